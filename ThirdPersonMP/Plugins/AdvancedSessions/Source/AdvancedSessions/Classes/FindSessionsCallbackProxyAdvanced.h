@@ -5,6 +5,7 @@
 #include "Interfaces/OnlineSessionInterface.h"
 #include "FindSessionsCallbackProxy.h"
 #include "BlueprintDataDefinitions.h"
+#include "SessionFilterProgram.h"
 #include "FindSessionsCallbackProxyAdvanced.generated.h"
 
 
@@ -26,6 +27,10 @@ class UFindSessionsCallbackProxyAdvanced : public UOnlineBlueprintCallProxyBase
 	UPROPERTY(BlueprintAssignable)
 	FBlueprintFindSessionsResultDelegate OnFailure;
 
+	// Called with the results so far when searching all servers and one of the two searches is still running
+	UPROPERTY(BlueprintAssignable)
+	FBlueprintFindSessionsResultDelegate OnPartialResults;
+
 	// Searches for advertised sessions with the default online subsystem and includes an array of filters
 	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject", AutoCreateRefTerm="Filters"), Category = "Online|AdvancedSessions")
 	static UFindSessionsCallbackProxyAdvanced* FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int32 MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly = false, bool bNonEmptyServersOnly = false, bool bSecureServersOnly = false, /*bool bSearchLobbies = true,*/ int MinSlotsAvailable = 0);
@@ -58,11 +63,32 @@ private:
 	// Internal callback when the session search completes, calls out to the public success/failure callbacks
 	void OnCompleted(bool bSuccess);
 
+	// Client side fallback for the slot settings pushed into the query, for subsystems that ignore them (LAN)
+	bool PassesSearchSettings(const FOnlineSessionSearchResult& Result) const;
+
+	// Starts the dedicated server search, or queues it if the subsystem won't run it alongside the lobby search
+	void StartDedicatedSearch(const IOnlineSessionPtr& Sessions, const FUniqueNetId& UserID);
+
+	// Adds the results of a finished search that pass the filters and weren't returned by the other search
+	void AddSearchResults(const FOnlineSessionSearch& Search, bool bIsLobbySearch);
+
+	// The dedicated search is waiting for the lobby search to finish
 	bool bRunSecondSearch;
-	bool bIsOnSecondSearch;
+
+	// Searches currently running
+	bool bIsSearchPending;
+	bool bIsDedicatedSearchPending;
+
+	// Set while starting the dedicated search, StartDedicatedSearch handles any callback fired from inside FindSessions
+	bool bStartingSecondSearch;
+
+	bool bAnySearchSucceeded;
 
 	TArray<FBlueprintSessionResult> SessionSearchResults;
 
+	// Ids of the sessions in SessionSearchResults, to drop sessions returned by both searches
+	TSet<FString> SeenSessionIds;
+
 private:
 	// The player controller triggering things
 	TWeakObjectPtr<APlayerController> PlayerControllerWeakPtr;
@@ -89,6 +115,9 @@ private:
 	// Store extra settings
 	TArray<FSessionsSearchSetting> SearchSettings;
 
+	// SearchSettings compiled for the client side fallback
+	FSessionFilterProgram SearchSettingsProgram;
+
 	// Search for empty servers only
 	bool bEmptyServersOnly;
 
@@ -0,0 +1,60 @@
+// Copyright 1998-2015 Epic Games, Inc. All Rights Reserved.
+#pragma once
+#include "CoreMinimal.h"
+#include "OnlineSessionSettings.h"
+#include "BlueprintDataDefinitions.h"
+
+// A set of session search filters compiled once and evaluated over many results.
+// Filter keys are de-duplicated and comparand values decoded when compiling. When evaluating, each key is looked up
+// once per result into a column of decoded values, then each filter runs over its key's column.
+// Results match UFindSessionsCallbackProxyAdvanced::CompareVariants: a missing key passes, a type mismatch fails.
+class ADVANCEDSESSIONS_API FSessionFilterProgram
+{
+public:
+	FSessionFilterProgram() = default;
+	explicit FSessionFilterProgram(const TArray<FSessionsSearchSetting>& Filters);
+
+	bool IsEmpty() const { return Instructions.Num() == 0; }
+
+	// Sets OutPasses[i] to whether Settings[i] passes every filter
+	// Reuses scratch columns kept on the program, so one program can't be evaluated from two threads at once
+	void Evaluate(TConstArrayView<const FOnlineSessionSettings*> Settings, TBitArray<>& OutPasses) const;
+
+private:
+	// A setting value decoded for comparison
+	struct FDecodedValue
+	{
+		// Empty when the setting is missing
+		EOnlineKeyValuePairDataType::Type Type = EOnlineKeyValuePairDataType::Empty;
+		bool bPresent = false;
+
+		bool Bool = false;
+		int32 Int32 = 0;
+		int64 Int64 = 0;
+		double Double = 0.0;
+	};
+
+	// One compiled filter
+	struct FInstruction
+	{
+		int32 KeyIndex = INDEX_NONE;
+		EOnlineComparisonOpRedux Op = EOnlineComparisonOpRedux::Equals;
+
+		// The comparand, settings of any other type fail
+		FDecodedValue Value;
+		FString String;
+
+		// Types and operators CompareVariants never accepts, so any present setting fails
+		bool bNeverPasses = false;
+	};
+
+	// Distinct filtered keys, and whether a filter compares the key as a string
+	TArray<FName> Keys;
+	TArray<bool> KeyNeedsString;
+
+	TArray<FInstruction> Instructions;
+
+	// Scratch columns kept between evaluations so repeated searches don't reallocate them
+	mutable TArray<FDecodedValue> Values;
+	mutable TArray<FString> Strings;
+};
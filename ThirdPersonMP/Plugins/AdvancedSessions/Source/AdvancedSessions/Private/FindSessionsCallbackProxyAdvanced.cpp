@@ -3,6 +3,10 @@
 
 #include "Online/OnlineSessionNames.h"
 
+DECLARE_STATS_GROUP(TEXT("AdvancedSessions"), STATGROUP_AdvancedSessions, STATCAT_Advanced);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Find Sessions Results Transferred"), STAT_FindSessionsResultsTransferred, STATGROUP_AdvancedSessions);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Find Sessions Results Kept"), STAT_FindSessionsResultsKept, STATGROUP_AdvancedSessions);
+
 //////////////////////////////////////////////////////////////////////////
 // UFindSessionsCallbackProxyAdvanced
 
@@ -13,7 +17,10 @@ UFindSessionsCallbackProxyAdvanced::UFindSessionsCallbackProxyAdvanced(const FOb
 	, bUseLAN(false)
 {
 	bRunSecondSearch = false;
-	bIsOnSecondSearch = false;
+	bIsSearchPending = false;
+	bIsDedicatedSearchPending = false;
+	bStartingSecondSearch = false;
+	bAnySearchSucceeded = false;
 }
 
 UFindSessionsCallbackProxyAdvanced* UFindSessionsCallbackProxyAdvanced::FindSessionsAdvanced(UObject* WorldContextObject, class APlayerController* PlayerController, int MaxResults, bool bUseLAN, EBPServerPresenceSearchType ServerTypeToSearch, const TArray<FSessionsSearchSetting> &Filters, bool bEmptyServersOnly, bool bNonEmptyServersOnly, bool bSecureServersOnly, /*bool bSearchLobbies,*/ int MinSlotsAvailable)
@@ -45,7 +52,13 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 		{
 			// Re-initialize here, otherwise I think there might be issues with people re-calling search for some reason before it is destroyed
 			bRunSecondSearch = false;
-			bIsOnSecondSearch = false;
+			bIsSearchPending = false;
+			bIsDedicatedSearchPending = false;
+			bStartingSecondSearch = false;
+			bAnySearchSucceeded = false;
+			SessionSearchResults.Reset();
+			SeenSessionIds.Reset();
+			SearchSettingsProgram = FSessionFilterProgram(SearchSettings);
 
 			DelegateHandle = Sessions->AddOnFindSessionsCompleteDelegate_Handle(Delegate);
 
@@ -154,8 +167,26 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 			// Copy the derived temp variable over to it's base class
 			SearchObject->QuerySettings = tem;
 
+			bIsSearchPending = true;
 			Sessions->FindSessions(*Helper.UserID, SearchObject.ToSharedRef());
 
+			// Steam and NULL ignore a search while another one is running, without ever calling back
+			if (bIsSearchPending && SearchObject->SearchState == EOnlineAsyncTaskState::NotStarted)
+			{
+				FFrame::KismetExecutionMessage(TEXT("Another session search is already running"), ELogVerbosity::Warning);
+				bIsSearchPending = false;
+				bRunSecondSearch = false;
+				Sessions->ClearOnFindSessionsCompleteDelegate_Handle(DelegateHandle);
+				OnFailure.Broadcast(SessionSearchResults);
+				return;
+			}
+
+			// Run the dedicated search alongside the lobby search, unless a failed lobby search already started it
+			if (bRunSecondSearch)
+			{
+				StartDedicatedSearch(Sessions, *Helper.UserID);
+			}
+
 			// OnQueryCompleted will get called, nothing more to do now
 			return;
 		}
@@ -169,136 +200,199 @@ void UFindSessionsCallbackProxyAdvanced::Activate()
 	OnFailure.Broadcast(SessionSearchResults);
 }
 
-void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
+void UFindSessionsCallbackProxyAdvanced::StartDedicatedSearch(const IOnlineSessionPtr& Sessions, const FUniqueNetId& UserID)
 {
-	FOnlineSubsystemBPCallHelperAdvanced Helper(TEXT("FindSessionsCallback"), GEngine->GetWorldFromContextObject(WorldContextObject.Get(), EGetWorldErrorMode::LogAndReturnNull));
-	Helper.QueryIDFromPlayerController(PlayerControllerWeakPtr.Get());
+	bRunSecondSearch = false;
+	bIsDedicatedSearchPending = true;
 
-	if (!Helper.IsValid())
-	{
-		// Fail immediately
-		OnFailure.Broadcast(SessionSearchResults);
+	// A search finishing inside FindSessions is handled below rather than in OnCompleted
+	bStartingSecondSearch = true;
+	Sessions->FindSessions(UserID, SearchObjectDedicated.ToSharedRef());
+	bStartingSecondSearch = false;
+
+	const EOnlineAsyncTaskState::Type State = SearchObjectDedicated->SearchState;
+	if (State == EOnlineAsyncTaskState::InProgress)
 		return;
-	}
 
-	if (!bRunSecondSearch && Helper.IsValid())
+	if (State == EOnlineAsyncTaskState::Done)
 	{
-		auto Sessions = Helper.OnlineSub->GetSessionInterface();
-		if (Sessions.IsValid())
-		{
-			Sessions->ClearOnFindSessionsCompleteDelegate_Handle(DelegateHandle);
-		}
+		bIsDedicatedSearchPending = false;
+		bAnySearchSucceeded = true;
+		AddSearchResults(*SearchObjectDedicated, false);
+	}
+	else if (bIsSearchPending)
+	{
+		// Steam and NULL only run one search at a time and drop this one without calling back, run it when the lobby search is done instead
+		bIsDedicatedSearchPending = false;
+		bRunSecondSearch = true;
+		SearchObjectDedicated->SearchState = EOnlineAsyncTaskState::NotStarted;
 	}
+	else
+	{
+		// Refused or failed straight away, the lobby search results are all there is
+		bIsDedicatedSearchPending = false;
+	}
+}
 
-	if (bSuccess)
+void UFindSessionsCallbackProxyAdvanced::AddSearchResults(const FOnlineSessionSearch& Search, bool bIsLobbySearch)
+{
+	INC_DWORD_STAT_BY(STAT_FindSessionsResultsTransferred, Search.SearchResults.Num());
+
+	SessionSearchResults.Reserve(SessionSearchResults.Num() + Search.SearchResults.Num());
+
+	// The filters were sent with the query, this only drops anything the subsystem didn't filter itself
+	TArray<const FOnlineSessionSettings*> ResultSettings;
+	ResultSettings.Reserve(Search.SearchResults.Num());
+	for (const FOnlineSessionSearchResult& Result : Search.SearchResults)
+		ResultSettings.Add(&Result.Session.SessionSettings);
+
+	TBitArray<> Passes;
+	SearchSettingsProgram.Evaluate(ResultSettings, Passes);
+
+	for (int32 ResultIndex = 0; ResultIndex < Search.SearchResults.Num(); ResultIndex++)
 	{
-		if (bIsOnSecondSearch)
-		{
-			if (SearchObjectDedicated.IsValid())
-			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObjectDedicated->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
+		const FOnlineSessionSearchResult& Result = Search.SearchResults[ResultIndex];
 
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
+		if (!Passes[ResultIndex] || !PassesSearchSettings(Result))
+			continue;
 
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
-					SessionSearchResults.AddUnique(BPResult);
-				}
-				OnSuccess.Broadcast(SessionSearchResults);
-				return;
-			}
-		}
-		else
-		{
-			if (SearchObject.IsValid())
-			{
-				// Just log the results for now, will need to add a blueprint-compatible search result struct
-				for (auto& Result : SearchObject->SearchResults)
-				{
-					FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
+		// Both searches can return the same session
+		bool bAlreadySeen = false;
+		SeenSessionIds.Add(Result.GetSessionIdStr(), &bAlreadySeen);
+		if (bAlreadySeen)
+			continue;
 
-					FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
+		INC_DWORD_STAT(STAT_FindSessionsResultsKept);
 
-					FBlueprintSessionResult BPResult;
-					BPResult.OnlineResult = Result;
+		FString ResultText = FString::Printf(TEXT("Found a session. Ping is %d"), Result.PingInMs);
 
-					// Temp for 5.5, force the values if epic isn't setting them, lobbies should always have these true
-					if (ServerSearchType != EBPServerPresenceSearchType::DedicatedServersOnly )
-					{
-						BPResult.OnlineResult.Session.SessionSettings.bUseLobbiesIfAvailable = true;
-						BPResult.OnlineResult.Session.SessionSettings.bUsesPresence = true;
-					}
+		FFrame::KismetExecutionMessage(*ResultText, ELogVerbosity::Log);
 
-					SessionSearchResults.AddUnique(BPResult);
-				}
-				if (!bRunSecondSearch)
-				{
-					OnSuccess.Broadcast(SessionSearchResults);
-					return;
-				}
-			}
+		FBlueprintSessionResult& BPResult = SessionSearchResults.AddDefaulted_GetRef();
+		BPResult.OnlineResult = Result;
+
+		// Temp for 5.5, force the values if epic isn't setting them, lobbies should always have these true
+		if (bIsLobbySearch)
+		{
+			BPResult.OnlineResult.Session.SessionSettings.bUseLobbiesIfAvailable = true;
+			BPResult.OnlineResult.Session.SessionSettings.bUsesPresence = true;
 		}
 	}
+}
+
+void UFindSessionsCallbackProxyAdvanced::OnCompleted(bool bSuccess)
+{
+	// StartDedicatedSearch handles a dedicated search that finishes while starting
+	if (bStartingSecondSearch)
+		return;
+
+	// The delegate doesn't say which search completed, find the one that stopped running
+	TSharedPtr<FOnlineSessionSearch> FinishedSearch;
+	if (bIsSearchPending && SearchObject.IsValid() && SearchObject->SearchState != EOnlineAsyncTaskState::InProgress)
+	{
+		bIsSearchPending = false;
+		FinishedSearch = SearchObject;
+	}
+	else if (bIsDedicatedSearchPending && SearchObjectDedicated.IsValid() && SearchObjectDedicated->SearchState != EOnlineAsyncTaskState::InProgress)
+	{
+		bIsDedicatedSearchPending = false;
+		FinishedSearch = SearchObjectDedicated;
+	}
 	else
 	{
-		if (!bRunSecondSearch)
-		{
-			// Need to account for only one of the searches failing
-			if (SessionSearchResults.Num() > 0)
-				OnSuccess.Broadcast(SessionSearchResults);
-			else
-				OnFailure.Broadcast(SessionSearchResults);
-			return;
-		}
+		// Not one of ours
+		return;
 	}
 
-	if (Helper.IsValid() && bRunSecondSearch && ServerSearchType == EBPServerPresenceSearchType::AllServers)
+	FOnlineSubsystemBPCallHelperAdvanced Helper(TEXT("FindSessionsCallback"), GEngine->GetWorldFromContextObject(WorldContextObject.Get(), EGetWorldErrorMode::LogAndReturnNull));
+	Helper.QueryIDFromPlayerController(PlayerControllerWeakPtr.Get());
+
+	if (!Helper.IsValid())
 	{
+		// Fail immediately
+		bIsSearchPending = false;
+		bIsDedicatedSearchPending = false;
 		bRunSecondSearch = false;
-		bIsOnSecondSearch = true;
-		auto Sessions = Helper.OnlineSub->GetSessionInterface();
-		Sessions->FindSessions(*Helper.UserID, SearchObjectDedicated.ToSharedRef());
+		OnFailure.Broadcast(SessionSearchResults);
+		return;
 	}
-	else // We lost our player controller
+
+	auto Sessions = Helper.OnlineSub->GetSessionInterface();
+
+	if (bSuccess)
 	{
-		if (bSuccess && SessionSearchResults.Num() > 0)
-			OnSuccess.Broadcast(SessionSearchResults);
-		else
-			OnFailure.Broadcast(SessionSearchResults);
+		bAnySearchSucceeded = true;
+
+		const bool bIsLobbySearch = FinishedSearch == SearchObject && ServerSearchType != EBPServerPresenceSearchType::DedicatedServersOnly;
+		AddSearchResults(*FinishedSearch, bIsLobbySearch);
+	}
+
+	// The subsystem couldn't run both searches at once, the dedicated one can start now
+	if (bRunSecondSearch && !bIsSearchPending && Sessions.IsValid())
+	{
+		StartDedicatedSearch(Sessions, *Helper.UserID);
+	}
+
+	if (bIsSearchPending || bIsDedicatedSearchPending)
+	{
+		OnPartialResults.Broadcast(SessionSearchResults);
+		return;
 	}
+
+	if (Sessions.IsValid())
+	{
+		Sessions->ClearOnFindSessionsCompleteDelegate_Handle(DelegateHandle);
+	}
+
+	// Need to account for only one of the searches failing
+	if (bAnySearchSucceeded || SessionSearchResults.Num() > 0)
+		OnSuccess.Broadcast(SessionSearchResults);
+	else
+		OnFailure.Broadcast(SessionSearchResults);
 }
 
 
+bool UFindSessionsCallbackProxyAdvanced::PassesSearchSettings(const FOnlineSessionSearchResult& Result) const
+{
+	const int32 OpenSlots = Result.Session.NumOpenPublicConnections;
+	const int32 MaxSlots = Result.Session.SessionSettings.NumPublicConnections;
+
+	if (bEmptyServersOnly && OpenSlots < MaxSlots)
+		return false;
+
+	if (bNonEmptyServersOnly && OpenSlots >= MaxSlots)
+		return false;
+
+	if (MinSlotsAvailable > 0 && OpenSlots < MinSlotsAvailable)
+		return false;
+
+	// Secure servers can't be checked from the result, that one is left to the subsystem
+
+	return true;
+}
+
 void UFindSessionsCallbackProxyAdvanced::FilterSessionResults(const TArray<FBlueprintSessionResult> &SessionResults, const TArray<FSessionsSearchSetting> &Filters, TArray<FBlueprintSessionResult> &FilteredResults)
 {
-	for (int j = 0; j < SessionResults.Num(); j++)
+	// Results from FindSessionsAdvanced were already filtered by the same settings, this is for filtering them further afterwards
+	if (Filters.Num() == 0)
 	{
-		bool bAddResult = true;
+		FilteredResults.Append(SessionResults);
+		return;
+	}
 
-		// Filter results
-		if (Filters.Num() > 0)
-		{
-			const FOnlineSessionSetting * setting;
-			for (int i = 0; i < Filters.Num(); i++)
-			{
-				setting = SessionResults[j].OnlineResult.Session.SessionSettings.Settings.Find(Filters[i].PropertyKeyPair.Key);
+	const FSessionFilterProgram Program(Filters);
 
-				// Couldn't find this key
-				if (!setting)
-					continue;
+	TArray<const FOnlineSessionSettings*> ResultSettings;
+	ResultSettings.Reserve(SessionResults.Num());
+	for (int j = 0; j < SessionResults.Num(); j++)
+		ResultSettings.Add(&SessionResults[j].OnlineResult.Session.SessionSettings);
 
-				if (!CompareVariants(setting->Data, Filters[i].PropertyKeyPair.Data, Filters[i].ComparisonOp))
-				{
-					bAddResult = false;
-					break;
-				}
-			}
-		}
+	TBitArray<> Passes;
+	Program.Evaluate(ResultSettings, Passes);
 
-		if (bAddResult)
+	for (int j = 0; j < SessionResults.Num(); j++)
+	{
+		if (Passes[j])
 			FilteredResults.Add(SessionResults[j]);
 	}
 
@@ -402,7 +496,7 @@ bool UFindSessionsCallbackProxyAdvanced::CompareVariants(const FVariantData &A,
 	}
 	case EOnlineKeyValuePairDataType::Int64:
 	{
-		uint64 bA, bB;
+		int64 bA, bB;
 		A.GetValue(bA);
 		B.GetValue(bB);
 		switch (Comparator)
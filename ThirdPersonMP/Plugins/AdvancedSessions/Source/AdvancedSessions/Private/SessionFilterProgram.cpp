@@ -0,0 +1,260 @@
+#include "SessionFilterProgram.h"
+#include "FindSessionsCallbackProxyAdvanced.h"
+#include "AdvancedSessionsLibrary.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+
+namespace SessionFilterProgram
+{
+	template<typename T>
+	static bool Compare(const T& A, const T& B, EOnlineComparisonOpRedux Op)
+	{
+		switch (Op)
+		{
+		case EOnlineComparisonOpRedux::Equals: return A == B;
+		case EOnlineComparisonOpRedux::NotEquals: return A != B;
+		case EOnlineComparisonOpRedux::GreaterThanEquals: return A >= B;
+		case EOnlineComparisonOpRedux::LessThanEquals: return A <= B;
+		case EOnlineComparisonOpRedux::GreaterThan: return A > B;
+		case EOnlineComparisonOpRedux::LessThan: return A < B;
+		default: return false;
+		}
+	}
+
+	// Decodes everything but strings, those are only copied out for keys compared as strings
+	template<typename DecodedValueType>
+	static void Decode(const FVariantData& Data, DecodedValueType& Out)
+	{
+		Out.Type = Data.GetType();
+		Out.bPresent = true;
+
+		switch (Out.Type)
+		{
+		case EOnlineKeyValuePairDataType::Bool: Data.GetValue(Out.Bool); break;
+		case EOnlineKeyValuePairDataType::Int32: Data.GetValue(Out.Int32); break;
+		case EOnlineKeyValuePairDataType::Int64: Data.GetValue(Out.Int64); break;
+		case EOnlineKeyValuePairDataType::Double: Data.GetValue(Out.Double); break;
+		case EOnlineKeyValuePairDataType::Float:
+		{
+			float Value;
+			Data.GetValue(Value);
+			Out.Double = (double)Value;
+		}
+		break;
+		default: break;
+		}
+	}
+}
+
+FSessionFilterProgram::FSessionFilterProgram(const TArray<FSessionsSearchSetting>& Filters)
+{
+	Instructions.Reserve(Filters.Num());
+
+	for (const FSessionsSearchSetting& Filter : Filters)
+	{
+		FInstruction& Instruction = Instructions.AddDefaulted_GetRef();
+		Instruction.Op = Filter.ComparisonOp;
+
+		Instruction.KeyIndex = Keys.AddUnique(Filter.PropertyKeyPair.Key);
+		if (KeyNeedsString.Num() < Keys.Num())
+			KeyNeedsString.Add(false);
+
+		const FVariantData& Data = Filter.PropertyKeyPair.Data;
+		SessionFilterProgram::Decode(Data, Instruction.Value);
+
+		const bool bIsEquality = Filter.ComparisonOp == EOnlineComparisonOpRedux::Equals || Filter.ComparisonOp == EOnlineComparisonOpRedux::NotEquals;
+
+		switch (Data.GetType())
+		{
+		case EOnlineKeyValuePairDataType::Bool:
+			Instruction.bNeverPasses = !bIsEquality;
+			break;
+
+		case EOnlineKeyValuePairDataType::String:
+			if (bIsEquality)
+			{
+				Data.GetValue(Instruction.String);
+				KeyNeedsString[Instruction.KeyIndex] = true;
+			}
+			else
+			{
+				Instruction.bNeverPasses = true;
+			}
+			break;
+
+		case EOnlineKeyValuePairDataType::Int32:
+		case EOnlineKeyValuePairDataType::Int64:
+		case EOnlineKeyValuePairDataType::Float:
+		case EOnlineKeyValuePairDataType::Double:
+			break;
+
+		default:
+			Instruction.bNeverPasses = true;
+			break;
+		}
+	}
+}
+
+void FSessionFilterProgram::Evaluate(TConstArrayView<const FOnlineSessionSettings*> Settings, TBitArray<>& OutPasses) const
+{
+	const int32 NumResults = Settings.Num();
+	OutPasses.Init(true, NumResults);
+
+	if (IsEmpty() || NumResults == 0)
+		return;
+
+	// Pull the filtered settings out into one column per key, each key is looked up once per result
+	const int32 NumValues = Keys.Num() * NumResults;
+	Values.Reset();
+	Values.SetNum(NumValues);
+
+	// Strings left over from the last evaluation are overwritten or never read, as their values aren't present
+	if (KeyNeedsString.Contains(true) && Strings.Num() < NumValues)
+		Strings.SetNum(NumValues);
+
+	for (int32 KeyIndex = 0; KeyIndex < Keys.Num(); KeyIndex++)
+	{
+		const int32 ColumnStart = KeyIndex * NumResults;
+
+		for (int32 ResultIndex = 0; ResultIndex < NumResults; ResultIndex++)
+		{
+			const FOnlineSessionSetting* Setting = Settings[ResultIndex]->Settings.Find(Keys[KeyIndex]);
+			if (!Setting)
+				continue;
+
+			SessionFilterProgram::Decode(Setting->Data, Values[ColumnStart + ResultIndex]);
+
+			// FVariantData can only hand out a copy of a string
+			if (KeyNeedsString[KeyIndex] && Setting->Data.GetType() == EOnlineKeyValuePairDataType::String)
+				Setting->Data.GetValue(Strings[ColumnStart + ResultIndex]);
+		}
+	}
+
+	// Run each filter down its key's column
+	for (const FInstruction& Instruction : Instructions)
+	{
+		const int32 ColumnStart = Instruction.KeyIndex * NumResults;
+		const FDecodedValue* Column = Values.GetData() + ColumnStart;
+
+		for (int32 ResultIndex = 0; ResultIndex < NumResults; ResultIndex++)
+		{
+			const FDecodedValue& Value = Column[ResultIndex];
+
+			// Couldn't find this key
+			if (!Value.bPresent || !OutPasses[ResultIndex])
+				continue;
+
+			bool bPasses = false;
+			if (!Instruction.bNeverPasses && Value.Type == Instruction.Value.Type)
+			{
+				switch (Value.Type)
+				{
+				case EOnlineKeyValuePairDataType::Bool: bPasses = SessionFilterProgram::Compare(Value.Bool, Instruction.Value.Bool, Instruction.Op); break;
+				case EOnlineKeyValuePairDataType::Int32: bPasses = SessionFilterProgram::Compare(Value.Int32, Instruction.Value.Int32, Instruction.Op); break;
+				case EOnlineKeyValuePairDataType::Int64: bPasses = SessionFilterProgram::Compare(Value.Int64, Instruction.Value.Int64, Instruction.Op); break;
+				case EOnlineKeyValuePairDataType::Float:
+				case EOnlineKeyValuePairDataType::Double: bPasses = SessionFilterProgram::Compare(Value.Double, Instruction.Value.Double, Instruction.Op); break;
+				case EOnlineKeyValuePairDataType::String: bPasses = SessionFilterProgram::Compare(Strings[ColumnStart + ResultIndex], Instruction.String, Instruction.Op); break;
+				default: break;
+				}
+			}
+
+			if (!bPasses)
+				OutPasses[ResultIndex] = false;
+		}
+	}
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace SessionFilterProgram
+{
+	static void RunBenchmark()
+	{
+		const int32 NumResults = 10000;
+		const int32 NumIterations = 20;
+
+		// Synthetic results with a mix of setting types
+		FRandomStream Random(1234);
+		const TCHAR* MapNames[] = { TEXT("Lvl_ThirdPerson"), TEXT("Lvl_Combat"), TEXT("Lvl_Platforming"), TEXT("Lvl_SideScrolling") };
+
+		TArray<FOnlineSessionSearchResult> Results;
+		Results.SetNum(NumResults);
+		for (int32 i = 0; i < NumResults; i++)
+		{
+			FOnlineSessionSettings& SessionSettings = Results[i].Session.SessionSettings;
+			SessionSettings.Set(FName(TEXT("SERVER_NAME")), FString::Printf(TEXT("Server %d"), i), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+			SessionSettings.Set(FName(TEXT("MAPNAME")), FString(MapNames[Random.RandHelper(UE_ARRAY_COUNT(MapNames))]), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+			SessionSettings.Set(FName(TEXT("PLAYERS")), (int32)Random.RandRange(0, 16), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+			SessionSettings.Set(FName(TEXT("RANKED")), Random.RandHelper(2) == 0, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+			SessionSettings.Set(FName(TEXT("SKILL")), (double)Random.FRandRange(0.0f, 3000.0f), EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+		}
+
+		auto AddFilter = [](TArray<FSessionsSearchSetting>& Filters, const TCHAR* Key, const FVariantData& Data, EOnlineComparisonOpRedux Op)
+		{
+			FSessionsSearchSetting& Filter = Filters.AddDefaulted_GetRef();
+			Filter.PropertyKeyPair.Key = FName(Key);
+			Filter.PropertyKeyPair.Data = Data;
+			Filter.ComparisonOp = Op;
+		};
+
+		TArray<FSessionsSearchSetting> Filters;
+		AddFilter(Filters, TEXT("MAPNAME"), FVariantData(FString(TEXT("Lvl_ThirdPerson"))), EOnlineComparisonOpRedux::Equals);
+		AddFilter(Filters, TEXT("PLAYERS"), FVariantData((int32)2), EOnlineComparisonOpRedux::GreaterThanEquals);
+		AddFilter(Filters, TEXT("PLAYERS"), FVariantData((int32)16), EOnlineComparisonOpRedux::LessThan);
+		AddFilter(Filters, TEXT("RANKED"), FVariantData(true), EOnlineComparisonOpRedux::Equals);
+		AddFilter(Filters, TEXT("SKILL"), FVariantData(1500.0), EOnlineComparisonOpRedux::LessThanEquals);
+		AddFilter(Filters, TEXT("REGION"), FVariantData(FString(TEXT("EU"))), EOnlineComparisonOpRedux::Equals);
+
+		// Per result and filter, the way FilterSessionResults used to run
+		int32 NumPassedPerPair = 0;
+		const double PerPairStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			NumPassedPerPair = 0;
+			for (const FOnlineSessionSearchResult& Result : Results)
+			{
+				bool bAddResult = true;
+				for (const FSessionsSearchSetting& Filter : Filters)
+				{
+					const FOnlineSessionSetting* Setting = Result.Session.SessionSettings.Settings.Find(Filter.PropertyKeyPair.Key);
+					if (Setting && !UFindSessionsCallbackProxyAdvanced::CompareVariants(Setting->Data, Filter.PropertyKeyPair.Data, Filter.ComparisonOp))
+					{
+						bAddResult = false;
+						break;
+					}
+				}
+				NumPassedPerPair += bAddResult ? 1 : 0;
+			}
+		}
+		const double PerPairMs = (FPlatformTime::Seconds() - PerPairStart) * 1000.0 / NumIterations;
+
+		// Compiled once, then evaluated over the columns
+		int32 NumPassedCompiled = 0;
+		const double CompiledStart = FPlatformTime::Seconds();
+		for (int32 Iteration = 0; Iteration < NumIterations; Iteration++)
+		{
+			const FSessionFilterProgram Program(Filters);
+
+			TArray<const FOnlineSessionSettings*> Settings;
+			Settings.Reserve(NumResults);
+			for (const FOnlineSessionSearchResult& Result : Results)
+				Settings.Add(&Result.Session.SessionSettings);
+
+			TBitArray<> Passes;
+			Program.Evaluate(Settings, Passes);
+			NumPassedCompiled = Passes.CountSetBits();
+		}
+		const double CompiledMs = (FPlatformTime::Seconds() - CompiledStart) * 1000.0 / NumIterations;
+
+		UE_LOG(AdvancedSessionsLog, Log, TEXT("Filtering %d results with %d filters: per pair %.3f ms (%d passed), compiled %.3f ms (%d passed)"),
+			NumResults, Filters.Num(), PerPairMs, NumPassedPerPair, CompiledMs, NumPassedCompiled);
+	}
+}
+
+static FAutoConsoleCommand CCmdBenchmarkSessionFilters(
+	TEXT("AdvancedSessions.BenchmarkFilters"),
+	TEXT("Times filtering 10k synthetic session results per result and filter, against the compiled filter program."),
+	FConsoleCommandDelegate::CreateStatic(&SessionFilterProgram::RunBenchmark));
+
+#endif
@@ -0,0 +1,220 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AIThinkLODSubsystem.h"
+#include "ThinkLODStateTreeAIComponent.h"
+#include "PlayerTargetSubsystem.h"
+#include "ThirdPersonMP.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_CYCLE_STAT(TEXT("AI Think LOD Update"), STAT_AIThinkLODUpdate, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Thinks"), STAT_AIThinks, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("AI Thinks Deferred"), STAT_AIThinksDeferred, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<bool> CVarAIThinkLOD(
+	TEXT("ThirdPersonMP.AI.ThinkLOD"),
+	true,
+	TEXT("Lower the StateTree think rate and pawn tick rate of AI far from or out of sight of every player. When false, all AI think every frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAIThinkBudgetMs(
+	TEXT("ThirdPersonMP.AI.ThinkBudgetMs"),
+	2.0f,
+	TEXT("Milliseconds per frame AI may spend thinking. Further thinks are deferred to the next frame, except for AI near a player or overdue."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAIThinkLODUpdatesPerFrame(
+	TEXT("ThirdPersonMP.AI.ThinkLODUpdatesPerFrame"),
+	32,
+	TEXT("Number of AI whose think interval is re-evaluated each frame."),
+	ECVF_Default);
+
+namespace AIThinkLOD
+{
+	struct FTier
+	{
+		// Distance to the nearest player up to which the tier applies
+		float MaxDistance;
+
+		// Seconds between thinks
+		float ThinkInterval;
+	};
+
+	// The first tier is near a player and always thinks every frame
+	static constexpr FTier Tiers[] =
+	{
+		{ 1500.0f, 0.0f },
+		{ 4000.0f, 0.1f },
+		{ 10000.0f, 0.25f },
+		{ UE_BIG_NUMBER, 1.0f }
+	};
+
+	// AI that haven't thought for this many intervals think regardless of the budget
+	static constexpr float OverdueIntervals = 2.0f;
+
+	// How recently an AI must have been rendered to count as visible to the local player
+	static constexpr float RecentlyRenderedTolerance = 0.25f;
+}
+
+bool UAIThinkLODSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UAIThinkLODSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAIThinkLODSubsystem, STATGROUP_Tickables);
+}
+
+void UAIThinkLODSubsystem::Register(UThinkLODStateTreeAIComponent* Brain)
+{
+	Brains.AddUnique(Brain);
+}
+
+void UAIThinkLODSubsystem::Unregister(UThinkLODStateTreeAIComponent* Brain)
+{
+	Brains.RemoveSingleSwap(Brain);
+}
+
+bool UAIThinkLODSubsystem::RequestThink(const UThinkLODStateTreeAIComponent& Brain) const
+{
+	const float ThinkInterval = Brain.GetThinkInterval();
+	const float TimeSinceThink = Brain.GetTimeSinceThink();
+
+	if (TimeSinceThink < ThinkInterval)
+	{
+		return false;
+	}
+
+	// AI near a player, or that have waited too long, always think
+	if (Brain.IsNearPlayer() || TimeSinceThink >= ThinkInterval * AIThinkLOD::OverdueIntervals)
+	{
+		return true;
+	}
+
+	if (FrameThinkSeconds >= CVarAIThinkBudgetMs.GetValueOnGameThread() * 0.001)
+	{
+		INC_DWORD_STAT(STAT_AIThinksDeferred);
+		return false;
+	}
+
+	return true;
+}
+
+void UAIThinkLODSubsystem::ReportThink(const double Seconds)
+{
+	INC_DWORD_STAT(STAT_AIThinks);
+
+	FrameThinkSeconds += Seconds;
+}
+
+void UAIThinkLODSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// tickable objects run after the actors, so the budget starts over for the next frame
+	FrameThinkSeconds = 0.0;
+
+	UpdateSignificance();
+}
+
+void UAIThinkLODSubsystem::UpdateSignificance()
+{
+	SCOPE_CYCLE_COUNTER(STAT_AIThinkLODUpdate);
+
+	Brains.RemoveAllSwap([](const TWeakObjectPtr<UThinkLODStateTreeAIComponent>& Brain) { return !Brain.IsValid(); });
+
+	if (Brains.Num() == 0)
+	{
+		return;
+	}
+
+	// take the next slice of AIs, wrapping around
+	const int32 SliceSize = FMath::Clamp(CVarAIThinkLODUpdatesPerFrame.GetValueOnGameThread(), 1, Brains.Num());
+
+	TArray<UThinkLODStateTreeAIComponent*, TInlineAllocator<64>> SliceBrains;
+	TArray<APawn*, TInlineAllocator<64>> SlicePawns;
+	TArray<FVector, TInlineAllocator<64>> SliceOrigins;
+
+	for (int32 SliceIndex = 0; SliceIndex < SliceSize; ++SliceIndex)
+	{
+		UThinkLODStateTreeAIComponent* Brain = Brains[(NextBrainIndex + SliceIndex) % Brains.Num()].Get();
+		APawn* Pawn = Brain->GetControlledPawn();
+		if (!Pawn)
+		{
+			continue;
+		}
+
+		SliceBrains.Add(Brain);
+		SlicePawns.Add(Pawn);
+		SliceOrigins.Add(Pawn->GetActorLocation());
+	}
+
+	NextBrainIndex = (NextBrainIndex + SliceSize) % Brains.Num();
+
+	UPlayerTargetSubsystem* PlayerTargets = GetWorld()->GetSubsystem<UPlayerTargetSubsystem>();
+
+	// without LOD, everyone thinks every frame
+	if (!CVarAIThinkLOD.GetValueOnGameThread() || !PlayerTargets)
+	{
+		for (UThinkLODStateTreeAIComponent* Brain : SliceBrains)
+		{
+			Brain->SetThinkInterval(0.0f, true);
+		}
+
+		return;
+	}
+
+	TArray<APawn*> NearestPlayers;
+	PlayerTargets->FindNearestPlayers(SliceOrigins, UE_BIG_NUMBER, NearestPlayers);
+
+	const UWorld* World = GetWorld();
+	const float FarDistance = AIThinkLOD::Tiers[UE_ARRAY_COUNT(AIThinkLOD::Tiers) - 2].MaxDistance;
+
+	for (int32 SliceIndex = 0; SliceIndex < SliceBrains.Num(); ++SliceIndex)
+	{
+		APawn* Pawn = SlicePawns[SliceIndex];
+		const APawn* Player = NearestPlayers[SliceIndex];
+		const float Distance = Player ? FVector::Distance(SliceOrigins[SliceIndex], Player->GetActorLocation()) : UE_BIG_NUMBER;
+
+		// visibility only matters outside the near tier and inside the last one
+		bool bVisible = true;
+		if (Player && Distance >= AIThinkLOD::Tiers[0].MaxDistance && Distance < FarDistance)
+		{
+			bVisible = Pawn->WasRecentlyRendered(AIThinkLOD::RecentlyRenderedTolerance);
+
+			// remote players' views are unknown, so check their line of sight
+			if (!bVisible)
+			{
+				FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(AIThinkLODVisibility));
+				QueryParams.AddIgnoredActor(Pawn);
+				QueryParams.AddIgnoredActor(Player);
+
+				bVisible = !World->LineTraceTestByChannel(SliceOrigins[SliceIndex], Player->GetActorLocation(), ECC_Visibility, QueryParams);
+			}
+		}
+
+		SliceBrains[SliceIndex]->SetThinkInterval(GetThinkInterval(Distance, bVisible), Distance < AIThinkLOD::Tiers[0].MaxDistance);
+	}
+}
+
+float UAIThinkLODSubsystem::GetThinkInterval(const float Distance, const bool bVisible)
+{
+	constexpr int32 LastTier = UE_ARRAY_COUNT(AIThinkLOD::Tiers) - 1;
+
+	int32 Tier = 0;
+	while (Tier < LastTier && Distance >= AIThinkLOD::Tiers[Tier].MaxDistance)
+	{
+		++Tier;
+	}
+
+	// AI out of sight drop a tier, unless they're near a player
+	if (!bVisible && Tier > 0)
+	{
+		Tier = FMath::Min(Tier + 1, LastTier);
+	}
+
+	return AIThinkLOD::Tiers[Tier].ThinkInterval;
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "AIThinkLODSubsystem.generated.h"
+
+class UThinkLODStateTreeAIComponent;
+
+/**
+ * Think rate LOD scheduler for StateTree driven AI.
+ * Every registered AI gets a think interval from its distance and line of sight to the nearest player. Significance
+ * is re-evaluated for a rolling slice of the AIs each frame, which also staggers when each AI's interval starts.
+ * Thinks beyond the per-frame budget are deferred to a later frame, except for AIs near a player or already overdue.
+ */
+UCLASS()
+class THIRDPERSONMP_API UAIThinkLODSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Adds an AI to the scheduler. It thinks every frame until its first evaluation.
+	void Register(UThinkLODStateTreeAIComponent* Brain);
+
+	// Removes an AI from the scheduler
+	void Unregister(UThinkLODStateTreeAIComponent* Brain);
+
+	// Called by a brain when its think interval has elapsed. Returns false if the think should wait for a later frame.
+	bool RequestThink(const UThinkLODStateTreeAIComponent& Brain) const;
+
+	// Called by a brain after thinking, with the time it took
+	void ReportThink(double Seconds);
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Re-evaluates the think interval of the next slice of AIs
+	void UpdateSignificance();
+
+	// Returns the think interval for an AI at Distance from the nearest player
+	static float GetThinkInterval(float Distance, bool bVisible);
+
+	// Registered AIs, in round robin evaluation order
+	TArray<TWeakObjectPtr<UThinkLODStateTreeAIComponent>> Brains;
+
+	// Next AI to evaluate
+	int32 NextBrainIndex = 0;
+
+	// Time spent thinking this frame
+	double FrameThinkSeconds = 0.0;
+};
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ClientOnlyComponents.h"
+#include "ThirdPersonMP.h"
+#include "GameFramework/Actor.h"
+#include "HAL/IConsoleManager.h"
+
+DEFINE_STAT(STAT_CharacterSpawn);
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Stripped Client-Only Components"), STAT_StrippedClientOnlyComponents, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<bool> CVarStripClientOnlyComponents(
+	TEXT("ThirdPersonMP.StripClientOnlyComponents"),
+	true,
+	TEXT("Skip or strip cameras, spring arms and widget components of characters on dedicated servers."),
+	ECVF_Default);
+
+bool ClientOnlyComponents::ShouldStrip(const AActor* Actor)
+{
+	return Actor != nullptr && Actor->GetNetMode() == NM_DedicatedServer && CVarStripClientOnlyComponents.GetValueOnGameThread();
+}
+
+void ClientOnlyComponents::StripComponent(UActorComponent* Component)
+{
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	Component->DestroyComponent();
+	INC_DWORD_STAT(STAT_StrippedClientOnlyComponents);
+}
+
+void ClientOnlyComponents::ReportFootprint(const AActor* Actor)
+{
+	if (Actor == nullptr || !UE_LOG_ACTIVE(LogThirdPersonMP, Verbose))
+	{
+		return;
+	}
+
+	// Object sizes plus the exclusive resources (render data, physics bodies, etc.) owned by each component
+	SIZE_T NumBytes = Actor->GetClass()->GetStructureSize();
+	int32 NumComponents = 0;
+	for (const UActorComponent* Component : Actor->GetComponents())
+	{
+		if (IsValid(Component))
+		{
+			NumBytes += Component->GetClass()->GetStructureSize() + Component->GetResourceSizeBytes(EResourceSizeMode::Exclusive);
+			++NumComponents;
+		}
+	}
+
+	UE_LOG(LogThirdPersonMP, Verbose, TEXT("%s: %d components, %.1f KB"), *Actor->GetName(), NumComponents, NumBytes / 1024.0f);
+}
@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Stats/Stats.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Character Spawn"), STAT_CharacterSpawn, STATGROUP_ThirdPersonMP, THIRDPERSONMP_API);
+
+/**
+ * Keeps client-only components (cameras, spring arms, widget components) off dedicated servers.
+ *
+ * Owners create them with CreateOptionalDefaultSubobject, so the class defaults are the same in every process and
+ * subclasses can opt out with DoNotCreateDefaultSubobject. Actors in a dedicated server world (a server process, or
+ * PIE) strip them in PostInitializeComponents. Owners must null check the component pointers wherever they can run
+ * on a server.
+ *
+ * Stripping can be turned off with ThirdPersonMP.StripClientOnlyComponents=0 to compare the per-character footprint
+ * and spawn time reported by ReportFootprint and "stat ThirdPersonMP".
+ */
+namespace ClientOnlyComponents
+{
+	// True if the actor lives in a dedicated server world and its client-only components should be stripped
+	THIRDPERSONMP_API bool ShouldStrip(const AActor* Actor);
+
+	// Destroys the component and clears the reference to it
+	THIRDPERSONMP_API void StripComponent(UActorComponent* Component);
+
+	template <typename ComponentType>
+	void Strip(ComponentType*& Component)
+	{
+		StripComponent(Component);
+		Component = nullptr;
+	}
+
+	template <typename ComponentType>
+	void Strip(TObjectPtr<ComponentType>& Component)
+	{
+		StripComponent(Component);
+		Component = nullptr;
+	}
+
+	// Logs the number of components and their approximate memory for the actor, at Verbose
+	THIRDPERSONMP_API void ReportFootprint(const AActor* Actor);
+}
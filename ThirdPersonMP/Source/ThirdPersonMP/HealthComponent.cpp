@@ -0,0 +1,124 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HealthComponent.h"
+#include "ThirdPersonMP.h"
+#include "Net/UnrealNetwork.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Events"), STAT_DamageEvents, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Health Updates"), STAT_HealthUpdates, STATGROUP_ThirdPersonMP);
+
+UHealthComponent::UHealthComponent()
+{
+	// Only ticks for a frame after health changed on the server, to flush the changes of that frame
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	bWantsInitializeComponent = true;
+	SetIsReplicatedByDefault(true);
+
+	MaxHealth = 100.0f;
+	ReplicationCondition = COND_None;
+	QuantizedHealth = MAX_uint16;
+	Health = MaxHealth;
+	NotifiedHealth = MaxHealth;
+}
+
+void UHealthComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	FDoRepLifetimeParams Params;
+	Params.bIsPushBased = true;
+	Params.Condition = COND_Dynamic;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHealthComponent, QuantizedHealth, Params);
+}
+
+void UHealthComponent::InitializeComponent()
+{
+	Super::InitializeComponent();
+
+	// Owners read health before BeginPlay
+	Health = MaxHealth;
+	NotifiedHealth = MaxHealth;
+}
+
+void UHealthComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	DOREPDYNAMICCONDITION_INITCONDITION_FAST(UHealthComponent, QuantizedHealth, ReplicationCondition.GetValue());
+}
+
+float UHealthComponent::ApplyDamage(const float Damage)
+{
+	if (GetOwnerRole() != ROLE_Authority || Damage <= 0.0f || IsDead())
+	{
+		return 0.0f;
+	}
+
+	const float AppliedDamage = FMath::Min(Damage, Health);
+	Health -= AppliedDamage;
+
+	INC_DWORD_STAT(STAT_DamageEvents);
+	QueueHealthChanged();
+	return AppliedDamage;
+}
+
+void UHealthComponent::SetHealth(const float NewHealth)
+{
+	if (GetOwnerRole() != ROLE_Authority)
+	{
+		return;
+	}
+
+	Health = FMath::Clamp(NewHealth, 0.0f, MaxHealth);
+	QueueHealthChanged();
+}
+
+void UHealthComponent::ResetHealth()
+{
+	SetHealth(MaxHealth);
+}
+
+void UHealthComponent::QueueHealthChanged()
+{
+	SetComponentTickEnabled(true);
+}
+
+void UHealthComponent::TickComponent(const float DeltaTime, const ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	SetComponentTickEnabled(false);
+
+	if (Health == NotifiedHealth)
+	{
+		return;
+	}
+
+	const uint16 NewQuantizedHealth = MaxHealth > 0.0f ? static_cast<uint16>(FMath::RoundToInt32(Health / MaxHealth * MAX_uint16)) : 0;
+	if (NewQuantizedHealth != QuantizedHealth)
+	{
+		QuantizedHealth = NewQuantizedHealth;
+		MARK_PROPERTY_DIRTY_FROM_NAME(UHealthComponent, QuantizedHealth, this);
+	}
+
+	const float OldHealth = NotifiedHealth;
+	NotifiedHealth = Health;
+
+	INC_DWORD_STAT(STAT_HealthUpdates);
+	OnHealthChanged.Broadcast(this, OldHealth, Health);
+}
+
+void UHealthComponent::OnRep_QuantizedHealth()
+{
+	Health = static_cast<float>(QuantizedHealth) / MAX_uint16 * MaxHealth;
+
+	const float OldHealth = NotifiedHealth;
+	NotifiedHealth = Health;
+
+	OnHealthChanged.Broadcast(this, OldHealth, Health);
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "HealthComponent.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FOnHealthChanged, UHealthComponent*, HealthComponent, float, OldHealth, float, NewHealth);
+
+/**
+ * Health of an actor, shared by every damageable actor of the project.
+ * The server applies damage immediately, but OnHealthChanged fires at most once per frame, after all the hits of
+ * that frame. Health replicates as a quantized fraction of MaxHealth through the push model, so an unchanged health
+ * value is never compared, and only to the connections allowed by ReplicationCondition.
+ */
+UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
+class THIRDPERSONMP_API UHealthComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UHealthComponent();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+	virtual void InitializeComponent() override;
+	virtual void BeginPlay() override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	UFUNCTION(BlueprintPure, Category="Health")
+	float GetHealth() const { return Health; }
+
+	UFUNCTION(BlueprintPure, Category="Health")
+	float GetMaxHealth() const { return MaxHealth; }
+
+	UFUNCTION(BlueprintPure, Category="Health")
+	float GetHealthPercent() const { return MaxHealth > 0.0f ? Health / MaxHealth : 0.0f; }
+
+	UFUNCTION(BlueprintPure, Category="Health")
+	bool IsDead() const { return Health <= 0.0f; }
+
+	// Reduces health by Damage, clamped to 0. Returns the damage actually applied. Should only be called on the server.
+	float ApplyDamage(float Damage);
+
+	// Sets health, clamped between 0 and MaxHealth. Should only be called on the server.
+	UFUNCTION(BlueprintCallable, Category="Health")
+	void SetHealth(float NewHealth);
+
+	// Sets health back to MaxHealth. Should only be called on the server.
+	UFUNCTION(BlueprintCallable, Category="Health")
+	void ResetHealth();
+
+	// Called on the server and on clients when health changed, at most once per frame
+	UPROPERTY(BlueprintAssignable, Category="Health")
+	FOnHealthChanged OnHealthChanged;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Health", meta = (ClampMin = 0))
+	float MaxHealth;
+
+	// Connections health is replicated to. Can't be changed after BeginPlay.
+	UPROPERTY(EditAnywhere, Category="Health")
+	TEnumAsByte<ELifetimeCondition> ReplicationCondition;
+
+protected:
+	// Health as a fraction of MaxHealth, 0 to MAX_uint16
+	UPROPERTY(ReplicatedUsing = OnRep_QuantizedHealth)
+	uint16 QuantizedHealth;
+
+	UFUNCTION()
+	void OnRep_QuantizedHealth();
+
+	// Schedules OnHealthChanged and the replication of health for the end of the frame
+	void QueueHealthChanged();
+
+	float Health;
+
+	// Health at the last OnHealthChanged broadcast
+	float NotifiedHealth;
+};
@@ -0,0 +1,159 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ImpactEventReplicator.h"
+#include "Projectile.h"
+#include "ThirdPersonMPCharacter.h"
+#include "Components/AudioComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
+#include "Particles/ParticleSystemComponent.h"
+
+static TAutoConsoleVariable<int32> CVarImpactEmitterPoolSize(
+	TEXT("ThirdPersonMP.ImpactEmitterPoolSize"),
+	16,
+	TEXT("Number of particle and audio components each player reuses for impacts. The oldest one is restarted when all are playing. Applies to replicators spawned afterwards."),
+	ECVF_Default);
+
+void FImpactEvent::PostReplicatedAdd(const FImpactEventArray& InArraySerializer)
+{
+	// Events received with the replicator itself were already in the stream before this client connected, they are stale
+	if (InArraySerializer.Owner != nullptr && InArraySerializer.Owner->HasActorBegunPlay())
+	{
+		InArraySerializer.Owner->PlayImpactEvent(*this);
+	}
+}
+
+AImpactEventReplicator::AImpactEventReplicator()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	bReplicates = true;
+	bOnlyRelevantToOwner = true;
+	SetNetUpdateFrequency(30.0f);
+
+	ImpactEvents.Owner = this;
+}
+
+void AImpactEventReplicator::BeginPlay()
+{
+	Super::BeginPlay();
+
+	EmitterPoolSize = FMath::Max(CVarImpactEmitterPoolSize.GetValueOnGameThread(), 1);
+}
+
+void AImpactEventReplicator::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AImpactEventReplicator, ImpactEvents);
+}
+
+void AImpactEventReplicator::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Pooled components are owned by the world, not by this actor
+	for (UParticleSystemComponent* ParticleComponent : ParticlePool)
+	{
+		if (IsValid(ParticleComponent))
+		{
+			ParticleComponent->DestroyComponent();
+		}
+	}
+
+	for (UAudioComponent* AudioComponent : AudioPool)
+	{
+		if (IsValid(AudioComponent))
+		{
+			AudioComponent->DestroyComponent();
+		}
+	}
+
+	ParticlePool.Empty();
+	AudioPool.Empty();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AImpactEventReplicator::AddImpactEvent(const FImpactEvent& ImpactEvent)
+{
+	FImpactEvent& NewEvent = ImpactEvents.Items.Add_GetRef(ImpactEvent);
+	ImpactEvents.MarkItemDirty(NewEvent);
+}
+
+void AImpactEventReplicator::RemoveExpiredEvents(const double MinServerTime)
+{
+	const int32 NumRemoved = ImpactEvents.Items.RemoveAll([MinServerTime](const FImpactEvent& ImpactEvent)
+	{
+		return ImpactEvent.ServerTime < MinServerTime;
+	});
+
+	if (NumRemoved > 0)
+	{
+		ImpactEvents.MarkArrayDirty();
+	}
+}
+
+void AImpactEventReplicator::PlayImpactEvent(const FImpactEvent& ImpactEvent)
+{
+	const AProjectile* ProjectileDefaults = ImpactEvent.Type != nullptr ? ImpactEvent.Type->GetDefaultObject<AProjectile>() : nullptr;
+	if (ProjectileDefaults == nullptr || GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// The shooter already saw the explosion of its predicted projectile
+	if (ImpactEvent.PredictionKey != 0)
+	{
+		const AThirdPersonMPCharacter* Shooter = Cast<AThirdPersonMPCharacter>(ImpactEvent.Instigator);
+		if (Shooter != nullptr && Shooter->IsLocallyControlled() && Shooter->HasShownPredictedImpact(ImpactEvent.PredictionKey))
+		{
+			return;
+		}
+	}
+
+	const int32 Slot = NextPoolSlot;
+	NextPoolSlot = (NextPoolSlot + 1) % EmitterPoolSize;
+
+	if (ProjectileDefaults->ExplosionEffect != nullptr)
+	{
+		if (!ParticlePool.IsValidIndex(Slot))
+		{
+			ParticlePool.SetNum(EmitterPoolSize);
+		}
+
+		TObjectPtr<UParticleSystemComponent>& ParticleComponent = ParticlePool[Slot];
+		if (ParticleComponent == nullptr)
+		{
+			ParticleComponent = UGameplayStatics::SpawnEmitterAtLocation(this, ProjectileDefaults->ExplosionEffect, ImpactEvent.Location, FRotator::ZeroRotator, false);
+		}
+		else
+		{
+			ParticleComponent->SetTemplate(ProjectileDefaults->ExplosionEffect);
+			ParticleComponent->SetWorldLocation(ImpactEvent.Location);
+			ParticleComponent->ActivateSystem(true);
+		}
+	}
+
+	if (ProjectileDefaults->SoundEffect != nullptr)
+	{
+		if (!AudioPool.IsValidIndex(Slot))
+		{
+			AudioPool.SetNum(EmitterPoolSize);
+		}
+
+		TObjectPtr<UAudioComponent>& AudioComponent = AudioPool[Slot];
+		if (AudioComponent == nullptr)
+		{
+			AudioComponent = UGameplayStatics::SpawnSoundAtLocation(this, ProjectileDefaults->SoundEffect, ImpactEvent.Location, FRotator::ZeroRotator, 0.5f, 1.0f, 0.0f, nullptr, nullptr, false);
+		}
+		else
+		{
+			AudioComponent->SetSound(ProjectileDefaults->SoundEffect);
+			AudioComponent->SetWorldLocation(ImpactEvent.Location);
+			AudioComponent->Play();
+		}
+	}
+}
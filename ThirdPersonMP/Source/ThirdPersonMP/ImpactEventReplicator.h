@@ -0,0 +1,111 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "ImpactEventReplicator.generated.h"
+
+class AImpactEventReplicator;
+class AProjectile;
+class UAudioComponent;
+class UParticleSystemComponent;
+
+// A single impact to show on clients
+USTRUCT()
+struct FImpactEvent : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location = FVector::ZeroVector;
+
+	// Projectile class that impacted, its defaults hold the effect and sound to play
+	UPROPERTY()
+	TSubclassOf<AProjectile> Type;
+
+	UPROPERTY()
+	TObjectPtr<APawn> Instigator;
+
+	// Prediction key of the shot, 0 if the shot was not predicted by the instigator's client
+	UPROPERTY()
+	uint16 PredictionKey = 0;
+
+	// Server only. World time the event was added at, used to expire it.
+	double ServerTime = 0.0;
+
+	void PostReplicatedAdd(const struct FImpactEventArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FImpactEventArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FImpactEvent> Items;
+
+	// Replicator playing the events received on the client
+	AImpactEventReplicator* Owner = nullptr;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FImpactEvent, FImpactEventArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FImpactEventArray> : public TStructOpsTypeTraitsBase2<FImpactEventArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+/**
+ * Delivers impact events to a single player.
+ * One replicator is spawned per player controller by UImpactEventSubsystem and is only relevant to that player,
+ * so each connection only receives the impacts within its cull distance. Events are played on the client from a
+ * small set of reused particle and audio components. Events that arrive with the replicator itself happened before the
+ * client connected and are not played.
+ */
+UCLASS(NotPlaceable)
+class THIRDPERSONMP_API AImpactEventReplicator : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	AImpactEventReplicator();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Adds an event for the owning player to receive. Should only be called on the server.
+	void AddImpactEvent(const FImpactEvent& ImpactEvent);
+
+	// Removes the events added before MinServerTime. Should only be called on the server.
+	void RemoveExpiredEvents(double MinServerTime);
+
+	// Plays the effect and sound of the event, unless the owning player already saw it through its own prediction
+	void PlayImpactEvent(const FImpactEvent& ImpactEvent);
+
+protected:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Number of particle and audio components reused for impacts, read from ThirdPersonMP.ImpactEmitterPoolSize at BeginPlay
+	int32 EmitterPoolSize = 1;
+
+	UPROPERTY(Replicated)
+	FImpactEventArray ImpactEvents;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UParticleSystemComponent>> ParticlePool;
+
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UAudioComponent>> AudioPool;
+
+	// Index of the pool slot used by the next impact
+	int32 NextPoolSlot = 0;
+};
@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ImpactEventSubsystem.h"
+#include "ThirdPersonMP.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Distribute Impact Events"), STAT_DistributeImpactEvents, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impact Events"), STAT_ImpactEvents, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impact Events Sent"), STAT_ImpactEventsSent, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impact Events Culled"), STAT_ImpactEventsCulled, STATGROUP_ThirdPersonMP);
+
+void UImpactEventSubsystem::Deinitialize()
+{
+	PendingEvents.Empty();
+	Replicators.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UImpactEventSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UImpactEventSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UImpactEventSubsystem, STATGROUP_Tickables);
+}
+
+void UImpactEventSubsystem::AddImpactEvent(const FVector& Location, const TSubclassOf<AProjectile> Type, APawn* Instigator, const uint16 PredictionKey)
+{
+	if (GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FImpactEvent& ImpactEvent = PendingEvents.AddDefaulted_GetRef();
+	ImpactEvent.Location = Location;
+	ImpactEvent.Type = Type;
+	ImpactEvent.Instigator = Instigator;
+	ImpactEvent.PredictionKey = PredictionKey;
+	ImpactEvent.ServerTime = GetWorld()->GetTimeSeconds();
+
+	INC_DWORD_STAT(STAT_ImpactEvents);
+}
+
+void UImpactEventSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Replicators.IsEmpty() && PendingEvents.IsEmpty())
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_DistributeImpactEvents);
+
+	// Forget the replicators of players that left
+	for (auto It = Replicators.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			if (AImpactEventReplicator* Replicator = It.Value().Get())
+			{
+				Replicator->Destroy();
+			}
+
+			It.RemoveCurrent();
+		}
+	}
+
+	const UWorld* World = GetWorld();
+	const double MinServerTime = World->GetTimeSeconds() - EventLifetime;
+
+	for (FConstPlayerControllerIterator It = World->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (PlayerController == nullptr)
+		{
+			continue;
+		}
+
+		AImpactEventReplicator* Replicator = FindOrAddReplicator(PlayerController);
+		if (Replicator == nullptr)
+		{
+			continue;
+		}
+
+		Replicator->RemoveExpiredEvents(MinServerTime);
+
+		if (PendingEvents.IsEmpty())
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		for (const FImpactEvent& ImpactEvent : PendingEvents)
+		{
+			if (FVector::DistSquared(ViewLocation, ImpactEvent.Location) > FMath::Square(ImpactCullDistance))
+			{
+				INC_DWORD_STAT(STAT_ImpactEventsCulled);
+				continue;
+			}
+
+			// The listen server's own player plays the impact right away, there is no connection to send it through
+			if (PlayerController->IsLocalController())
+			{
+				Replicator->PlayImpactEvent(ImpactEvent);
+			}
+			else
+			{
+				Replicator->AddImpactEvent(ImpactEvent);
+				INC_DWORD_STAT(STAT_ImpactEventsSent);
+			}
+		}
+	}
+
+	PendingEvents.Reset();
+}
+
+AImpactEventReplicator* UImpactEventSubsystem::FindOrAddReplicator(APlayerController* PlayerController)
+{
+	if (const TWeakObjectPtr<AImpactEventReplicator>* ExistingReplicator = Replicators.Find(PlayerController))
+	{
+		if (AImpactEventReplicator* Replicator = ExistingReplicator->Get())
+		{
+			return Replicator;
+		}
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = PlayerController;
+
+	AImpactEventReplicator* Replicator = GetWorld()->SpawnActor<AImpactEventReplicator>(AImpactEventReplicator::StaticClass(), SpawnParameters);
+	if (Replicator == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn impact event replicator in UImpactEventSubsystem::FindOrAddReplicator()"));
+		return nullptr;
+	}
+
+	Replicators.Add(PlayerController, Replicator);
+	return Replicator;
+}
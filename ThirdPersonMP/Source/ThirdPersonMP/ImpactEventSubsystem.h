@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ImpactEventReplicator.h"
+#include "ImpactEventSubsystem.generated.h"
+
+class APlayerController;
+
+/**
+ * Server-side buffer of impact events.
+ * Impacts are collected during the frame and distributed once per tick to the AImpactEventReplicator of every player
+ * whose view is within ImpactCullDistance of the impact. Events stay in the replicated arrays for EventLifetime so they
+ * survive packet loss, instead of being sent once through an unreliable multicast to every connection.
+ */
+UCLASS()
+class THIRDPERSONMP_API UImpactEventSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Impacts further than this from a player's view point are not sent to that player
+	static constexpr double ImpactCullDistance = 15000.0;
+
+	// Time in seconds an event is kept in the replicated arrays
+	static constexpr double EventLifetime = 2.0;
+
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Queues an impact to show to nearby players. Does nothing on clients.
+	void AddImpactEvent(const FVector& Location, TSubclassOf<AProjectile> Type, APawn* Instigator, uint16 PredictionKey);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Returns the replicator of the player, spawning it if needed
+	AImpactEventReplicator* FindOrAddReplicator(APlayerController* PlayerController);
+
+	// Events added this frame, distributed on the next tick
+	TArray<FImpactEvent> PendingEvents;
+
+	TMap<TWeakObjectPtr<APlayerController>, TWeakObjectPtr<AImpactEventReplicator>> Replicators;
+};
@@ -0,0 +1,248 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "LagCompensationSubsystem.h"
+#include "ThirdPersonMP.h"
+#include "Components/CapsuleComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/Controller.h"
+#include "GameFramework/PlayerState.h"
+
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Record"), STAT_LagCompensationRecord, STATGROUP_ThirdPersonMP);
+DECLARE_CYCLE_STAT(TEXT("Lag Compensation Sweep"), STAT_LagCompensationSweep, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Lag Compensated Characters"), STAT_LagCompensatedCharacters, STATGROUP_ThirdPersonMP);
+DECLARE_MEMORY_STAT(TEXT("Lag Compensation History"), STAT_LagCompensationMemory, STATGROUP_ThirdPersonMP);
+
+namespace
+{
+	// Memory used by the history of a single character
+	constexpr int64 TrackMemorySize = ULagCompensationSubsystem::HistoryCapacity * (sizeof(FVector) + sizeof(float) + sizeof(bool));
+}
+
+bool ULagCompensationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void ULagCompensationSubsystem::OnWorldBeginPlay(UWorld& InWorld)
+{
+	Super::OnWorldBeginPlay(InWorld);
+
+	// Only servers with remote clients need to rewind
+	const ENetMode NetMode = InWorld.GetNetMode();
+	bIsRecording = NetMode == NM_DedicatedServer || NetMode == NM_ListenServer;
+	if (!bIsRecording)
+	{
+		return;
+	}
+
+	FrameTimes.SetNumZeroed(HistoryCapacity);
+
+	for (TActorIterator<ACharacter> It(&InWorld); It; ++It)
+	{
+		AddTrack(*It);
+	}
+
+	ActorSpawnedHandle = InWorld.AddOnActorSpawnedHandler(FOnActorSpawned::FDelegate::CreateUObject(this, &ULagCompensationSubsystem::OnActorSpawned));
+}
+
+void ULagCompensationSubsystem::Deinitialize()
+{
+	if (ActorSpawnedHandle.IsValid())
+	{
+		GetWorld()->RemoveOnActorSpawnedHandler(ActorSpawnedHandle);
+		ActorSpawnedHandle.Reset();
+	}
+
+	DEC_DWORD_STAT_BY(STAT_LagCompensatedCharacters, Tracks.Num());
+	DEC_MEMORY_STAT_BY(STAT_LagCompensationMemory, Tracks.Num() * TrackMemorySize);
+	Tracks.Empty();
+
+	Super::Deinitialize();
+}
+
+TStatId ULagCompensationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(ULagCompensationSubsystem, STATGROUP_Tickables);
+}
+
+void ULagCompensationSubsystem::OnActorSpawned(AActor* Actor)
+{
+	if (ACharacter* Character = Cast<ACharacter>(Actor))
+	{
+		AddTrack(Character);
+	}
+}
+
+void ULagCompensationSubsystem::AddTrack(ACharacter* Character)
+{
+	FCapsuleTrack& Track = Tracks.AddDefaulted_GetRef();
+	Track.Character = Character;
+	Track.FirstRecordedFrame = NumRecordedFrames;
+	Track.Locations.SetNumZeroed(HistoryCapacity);
+	Track.HalfHeights.SetNumZeroed(HistoryCapacity);
+	Track.Hittable.SetNumZeroed(HistoryCapacity);
+
+	INC_DWORD_STAT(STAT_LagCompensatedCharacters);
+	INC_MEMORY_STAT_BY(STAT_LagCompensationMemory, TrackMemorySize);
+}
+
+void ULagCompensationSubsystem::Tick(const float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (!bIsRecording)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationRecord);
+
+	const int32 Slot = NumRecordedFrames % HistoryCapacity;
+	FrameTimes[Slot] = GetWorld()->GetTimeSeconds();
+
+	for (int32 TrackIndex = Tracks.Num() - 1; TrackIndex >= 0; --TrackIndex)
+	{
+		FCapsuleTrack& Track = Tracks[TrackIndex];
+
+		const ACharacter* Character = Track.Character.Get();
+		if (!IsValid(Character))
+		{
+			Tracks.RemoveAtSwap(TrackIndex, 1, EAllowShrinking::No);
+			DEC_DWORD_STAT(STAT_LagCompensatedCharacters);
+			DEC_MEMORY_STAT_BY(STAT_LagCompensationMemory, TrackMemorySize);
+			continue;
+		}
+
+		const UCapsuleComponent* Capsule = Character->GetCapsuleComponent();
+		Track.Locations[Slot] = Capsule->GetComponentLocation();
+		Track.HalfHeights[Slot] = Capsule->GetScaledCapsuleHalfHeight();
+		Track.Radius = Capsule->GetScaledCapsuleRadius();
+		Track.Hittable[Slot] = Capsule->IsQueryCollisionEnabled() && !Character->IsHidden();
+	}
+
+	++NumRecordedFrames;
+}
+
+bool ULagCompensationSubsystem::FindFrames(const double Timestamp, uint32& OutOlderFrame, uint32& OutNewerFrame, float& OutAlpha) const
+{
+	if (NumRecordedFrames == 0)
+	{
+		return false;
+	}
+
+	const uint32 NewestFrame = NumRecordedFrames - 1;
+	const uint32 OldestFrame = NumRecordedFrames > HistoryCapacity ? NumRecordedFrames - HistoryCapacity : 0;
+
+	OutOlderFrame = OutNewerFrame = NewestFrame;
+	OutAlpha = 0.0f;
+
+	if (Timestamp >= FrameTimes[NewestFrame % HistoryCapacity])
+	{
+		return true;
+	}
+
+	for (uint32 Frame = NewestFrame; Frame > OldestFrame; --Frame)
+	{
+		const double OlderTime = FrameTimes[(Frame - 1) % HistoryCapacity];
+		if (OlderTime <= Timestamp)
+		{
+			const double NewerTime = FrameTimes[Frame % HistoryCapacity];
+
+			OutOlderFrame = Frame - 1;
+			OutNewerFrame = Frame;
+			OutAlpha = NewerTime > OlderTime ? static_cast<float>((Timestamp - OlderTime) / (NewerTime - OlderTime)) : 1.0f;
+			return true;
+		}
+	}
+
+	// Older than the history, use the oldest frame we still have
+	OutOlderFrame = OutNewerFrame = OldestFrame;
+	return true;
+}
+
+bool ULagCompensationSubsystem::SweepRewound(double Timestamp, const FVector& Start, const FVector& End, const float Radius, const AActor* IgnoredActor, TArray<FHitResult>& OutHits) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_LagCompensationSweep);
+
+	OutHits.Reset();
+
+	Timestamp = FMath::Max(Timestamp, GetWorld()->GetTimeSeconds() - MaxRewindTime);
+
+	uint32 OlderFrame, NewerFrame;
+	float Alpha;
+	if (!bIsRecording || !FindFrames(Timestamp, OlderFrame, NewerFrame, Alpha))
+	{
+		return false;
+	}
+
+	for (const FCapsuleTrack& Track : Tracks)
+	{
+		ACharacter* Character = Track.Character.Get();
+		if (!IsValid(Character) || Character == IgnoredActor || Track.FirstRecordedFrame > NewerFrame)
+		{
+			continue;
+		}
+
+		// Characters that spawned after the rewound frame are tested where they were first recorded
+		const int32 OlderSlot = FMath::Max(OlderFrame, Track.FirstRecordedFrame) % HistoryCapacity;
+		const int32 NewerSlot = NewerFrame % HistoryCapacity;
+
+		// Skip characters that couldn't be hit in the frame closest to the rewound time
+		if (!Track.Hittable[Alpha < 0.5f ? OlderSlot : NewerSlot])
+		{
+			continue;
+		}
+
+		const FVector Location = FMath::Lerp(Track.Locations[OlderSlot], Track.Locations[NewerSlot], Alpha);
+		const float HalfHeight = FMath::Lerp(Track.HalfHeights[OlderSlot], Track.HalfHeights[NewerSlot], Alpha);
+
+		// Test the sweep against the capsule's inner segment, inflated by both radii
+		const FVector AxisOffset(0.0f, 0.0f, FMath::Max(HalfHeight - Track.Radius, 0.0f));
+
+		FVector SweepPoint, CapsulePoint;
+		FMath::SegmentDistToSegmentSafe(Start, End, Location - AxisOffset, Location + AxisOffset, SweepPoint, CapsulePoint);
+
+		if (FVector::DistSquared(SweepPoint, CapsulePoint) > FMath::Square(Radius + Track.Radius))
+		{
+			continue;
+		}
+
+		FVector ImpactNormal = (SweepPoint - CapsulePoint).GetSafeNormal();
+		if (ImpactNormal.IsNearlyZero())
+		{
+			ImpactNormal = (Start - End).GetSafeNormal();
+		}
+
+		FHitResult& Hit = OutHits.Emplace_GetRef(Character, Character->GetCapsuleComponent(), CapsulePoint + ImpactNormal * Track.Radius, ImpactNormal);
+		Hit.TraceStart = Start;
+		Hit.TraceEnd = End;
+		Hit.Location = SweepPoint;
+		Hit.Distance = FVector::Dist(Start, SweepPoint);
+		Hit.bBlockingHit = true;
+	}
+
+	OutHits.Sort([](const FHitResult& A, const FHitResult& B) { return A.Distance < B.Distance; });
+	return OutHits.Num() > 0;
+}
+
+double ULagCompensationSubsystem::GetClientViewTimestamp(const AController* Controller) const
+{
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	if (Controller == nullptr || Controller->IsLocalController())
+	{
+		return Now;
+	}
+
+	const APlayerState* PlayerState = Controller->GetPlayerState<APlayerState>();
+	if (PlayerState == nullptr)
+	{
+		return Now;
+	}
+
+	// Remote clients see other characters roughly one round trip in the past
+	return Now - FMath::Min(PlayerState->GetPingInMilliseconds() * 0.001, MaxRewindTime);
+}
@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "LagCompensationSubsystem.generated.h"
+
+class ACharacter;
+class AController;
+
+/**
+ * Server-side history of character collision capsules used to validate hits the way the shooting client saw them.
+ * Every server tick the capsule of each ACharacter is recorded into a fixed size ring buffer. Hit checks can then
+ * rewind to a client timestamp and sweep against the capsules as they were at that time.
+ *
+ * Rewound capsules are tested analytically from the recorded data, so the live components are never moved and
+ * there is nothing to restore after the query (and no overlap events fire in the middle of a frame).
+ */
+UCLASS()
+class THIRDPERSONMP_API ULagCompensationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Number of recorded server frames kept per character. Bounds the memory used per character.
+	static constexpr int32 HistoryCapacity = 64;
+
+	// Maximum time in seconds a hit check can be rewound
+	static constexpr double MaxRewindTime = 0.5;
+
+	virtual void OnWorldBeginPlay(UWorld& InWorld) override;
+	virtual void Deinitialize() override;
+
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Sweeps a sphere of the given radius (0 for a line trace) against the character capsules as they were at Timestamp (server world time).
+	// Only characters are tested, world geometry should be traced separately. Hits are sorted by distance from Start.
+	bool SweepRewound(double Timestamp, const FVector& Start, const FVector& End, float Radius, const AActor* IgnoredActor, TArray<FHitResult>& OutHits) const;
+
+	// Returns the server world time the given controller's client was seeing, based on its ping. Falls back to the current time for local controllers.
+	double GetClientViewTimestamp(const AController* Controller) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Recorded capsule history of a single character. Samples are laid out as separate arrays indexed by frame slot.
+	struct FCapsuleTrack
+	{
+		TWeakObjectPtr<ACharacter> Character;
+		float Radius = 0.0f;
+		uint32 FirstRecordedFrame = 0;
+		TArray<FVector> Locations;
+		TArray<float> HalfHeights;
+
+		// False for frames where the character couldn't be hit: capsule collision off (dead) or hidden (pooled)
+		TArray<bool> Hittable;
+	};
+
+	void OnActorSpawned(AActor* Actor);
+	void AddTrack(ACharacter* Character);
+
+	// Finds the two recorded frames around Timestamp and the blend factor between them. Returns false if no frame was recorded yet.
+	bool FindFrames(double Timestamp, uint32& OutOlderFrame, uint32& OutNewerFrame, float& OutAlpha) const;
+
+	TArray<FCapsuleTrack> Tracks;
+
+	// Server world time of each frame slot
+	TArray<double> FrameTimes;
+
+	// Number of frames recorded since the subsystem started
+	uint32 NumRecordedFrames = 0;
+
+	bool bIsRecording = false;
+
+	FDelegateHandle ActorSpawnedHandle;
+};
@@ -4,6 +4,56 @@
 #include "MultiplayerSessionsSubsystem.h"
 #include "OnlineSubsystem.h"
 #include "Online/OnlineSessionNames.h"
+#include "ThirdPersonMP.h"
+#include "Engine/World.h"
+#include "Misc/CommandLine.h"
+#include "UObject/UObjectGlobals.h"
+#include "HAL/IConsoleManager.h"
+#include "GameFramework/GameModeBase.h"
+#include "Misc/App.h"
+#include "Icmp.h"
+
+DECLARE_CYCLE_STAT(TEXT("Merge Session Results"), STAT_MergeSessionResults, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Cached Sessions"), STAT_CachedSessions, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Session Results Transferred"), STAT_SessionResultsTransferred, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Session Results Kept"), STAT_SessionResultsKept, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Session Ping Probes"), STAT_SessionPingProbes, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<int32> CVarSessionsMaxMissedRefreshes(
+	TEXT("ThirdPersonMP.Sessions.MaxMissedRefreshes"),
+	2,
+	TEXT("Number of server list refreshes in a row a session can be missing from before it is dropped from the server browser."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSessionsPingProbeCount(
+	TEXT("ThirdPersonMP.Sessions.PingProbeCount"),
+	4,
+	TEXT("Number of best ranked sessions pinged before ranking them again with the measured latency."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSessionsPingProbeTimeout(
+	TEXT("ThirdPersonMP.Sessions.PingProbeTimeout"),
+	1.0f,
+	TEXT("Seconds to wait for a session host to answer a ping. Hosts that don't answer keep the ping reported by the search."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSessionsTickMsWeight(
+	TEXT("ThirdPersonMP.Sessions.TickMsWeight"),
+	2.0f,
+	TEXT("Milliseconds of latency each millisecond of a host's advertised frame time counts as when ranking sessions."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSessionsPlayerCountWeight(
+	TEXT("ThirdPersonMP.Sessions.PlayerCountWeight"),
+	5.0f,
+	TEXT("Milliseconds of latency each player on a host counts as when ranking sessions."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSessionsLoadAdvertiseInterval(
+	TEXT("ThirdPersonMP.Sessions.LoadAdvertiseInterval"),
+	10.0f,
+	TEXT("Seconds between updates of the player count and frame time a host advertises in its session."),
+	ECVF_Default);
 
 void PrintString(const FString& String)
 {
@@ -40,11 +90,74 @@ void UMultiplayerSessionsSubsystem::Initialize(FSubsystemCollectionBase& Collect
 			SessionInterface->OnJoinSessionCompleteDelegates.AddUObject(this, &UMultiplayerSessionsSubsystem::OnJoinSessionComplete);
 		}
 	}
+
+	// dedicated servers boot straight into the ServerDefaultMap, advertise the session once it is loaded
+	if (IsRunningDedicatedServer())
+	{
+		PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UMultiplayerSessionsSubsystem::OnPostLoadMapWithWorld);
+	}
 }
 
 void UMultiplayerSessionsSubsystem::Deinitialize()
 {
 	UE_LOG(LogTemp, Warning, TEXT("MSS Deinitialize"));
+
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	PostLoadMapHandle.Reset();
+
+	StopAdvertisingLoad();
+}
+
+void UMultiplayerSessionsSubsystem::OnPostLoadMapWithWorld(UWorld* LoadedWorld)
+{
+	if (LoadedWorld == nullptr || LoadedWorld->GetGameInstance() != GetGameInstance())
+	{
+		return;
+	}
+
+	// only advertise once, later map loads reuse the session
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	PostLoadMapHandle.Reset();
+
+	CreateDedicatedServerSession();
+}
+
+void UMultiplayerSessionsSubsystem::CreateDedicatedServerSession()
+{
+	if (!IsRunningDedicatedServer())
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Not running a dedicated server in UMultiplayerSessionsSubsystem::CreateDedicatedServerSession()"));
+		return;
+	}
+
+	if (!SessionInterface.IsValid())
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("SessionInterface is invalid in UMultiplayerSessionsSubsystem::CreateDedicatedServerSession()"));
+		return;
+	}
+
+	FString ServerName = TEXT("Dedicated server");
+	FParse::Value(FCommandLine::Get(), TEXT("ServerName="), ServerName);
+
+	// there is no local user on a dedicated server, so no presence and no lobby
+	FOnlineSessionSettings SessionSettings;
+	SessionSettings.bAllowJoinInProgress = true;
+	SessionSettings.bIsDedicated = true;
+	SessionSettings.bShouldAdvertise = true;
+	SessionSettings.NumPublicConnections = 4;
+	SessionSettings.bUseLobbiesIfAvailable = false;
+	SessionSettings.bUsesPresence = false;
+	SessionSettings.bAllowJoinViaPresence = false;
+	SessionSettings.bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
+
+	SessionSettings.Set(SETTING_SERVER_NAME, ServerName, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.Set(SETTING_PLAYER_COUNT, 0, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.Set(SETTING_AVG_TICK_MS, 0.0f, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+
+	UE_LOG(LogThirdPersonMP, Log, TEXT("Creating dedicated server session %s"), *ServerName);
+
+	bIsDedicatedServerSession = true;
+	SessionInterface->CreateSession(0, MySessionName, SessionSettings);
 }
 
 void UMultiplayerSessionsSubsystem::CreateServer(FString ServerName)
@@ -77,7 +190,9 @@ void UMultiplayerSessionsSubsystem::CreateServer(FString ServerName)
 	SessionSettings.bAllowJoinViaPresence = true;
 	SessionSettings.bIsLANMatch = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
 	
-	SessionSettings.Set(FName("SERVER_NAME"), ServerName, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.Set(SETTING_SERVER_NAME, ServerName, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.Set(SETTING_PLAYER_COUNT, 0, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	SessionSettings.Set(SETTING_AVG_TICK_MS, 0.0f, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
 	
 	SessionInterface->CreateSession(0, MySessionName, SessionSettings);
 }
@@ -92,18 +207,91 @@ void UMultiplayerSessionsSubsystem::FindServer(FString ServerName)
 		return;
 	}
 	
-	SessionSearch = MakeShareable(new FOnlineSessionSearch());
-	SessionSearch->bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
-	SessionSearch->MaxSearchResults = 9999;
-	
-	SessionSearch->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
-	
 	ServerNameToFind = ServerName;
 	
-	SessionInterface->FindSessions(0, SessionSearch.ToSharedRef());
+	StartSessionSearch();
+}
+
+void UMultiplayerSessionsSubsystem::RefreshServerList()
+{
+	PrintString("Refreshing server list");
+
+	ServerNameToFind = "";
+
+	StartSessionSearch();
+}
+
+void UMultiplayerSessionsSubsystem::StartSessionSearch()
+{
+	// a search is already running, its results will be handled with the current ServerNameToFind
+	if (bSearchInFlight)
+	{
+		return;
+	}
+
+	if (!SessionSearch.IsValid())
+	{
+		const bool bIsLanQuery = IOnlineSubsystem::Get()->GetSubsystemName() == "NULL";
+
+		SessionSearch = MakeShareable(new FOnlineSessionSearch());
+		SessionSearch->bIsLanQuery = bIsLanQuery;
+		SessionSearch->MaxSearchResults = 9999;
+	
+		SessionSearch->QuerySettings.Set(SEARCH_LOBBIES, true, EOnlineComparisonOp::Equals);
+
+		// dedicated servers don't create lobbies, so the lobby search never returns them
+		if (!bIsLanQuery)
+		{
+			DedicatedSessionSearch = MakeShareable(new FOnlineSessionSearch());
+			DedicatedSessionSearch->bIsLanQuery = false;
+			DedicatedSessionSearch->MaxSearchResults = 9999;
+		}
+	}
+
+	// let the backend filter by name when it can, the name index is the fallback for the ones that can't (LAN)
+	bSearchIsFiltered = !ServerNameToFind.IsEmpty();
+
+	for (const TSharedPtr<FOnlineSessionSearch>& Search : { SessionSearch, DedicatedSessionSearch })
+	{
+		if (!Search.IsValid())
+		{
+			continue;
+		}
+
+		if (bSearchIsFiltered)
+		{
+			Search->QuerySettings.Set(SETTING_SERVER_NAME, ServerNameToFind, EOnlineComparisonOp::Equals);
+		}
+		else
+		{
+			Search->QuerySettings.SearchParams.Remove(SETTING_SERVER_NAME);
+		}
+
+		Search->SearchResults.Reset();
+	}
+
+	++SearchSerial;
+	bAnySearchSucceeded = false;
+
+	StartSearch(SessionSearch, false);
 }
 
-void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(const FName SessionName, const bool bWasSuccessful) const
+void UMultiplayerSessionsSubsystem::StartSearch(const TSharedPtr<FOnlineSessionSearch>& Search, const bool bDedicated)
+{
+	bSearchingDedicated = bDedicated;
+	bSearchInFlight = true;
+
+	SessionInterface->FindSessions(0, Search.ToSharedRef());
+
+	// a subsystem busy with another search (the AdvancedSessions Blueprint nodes) ignores this one without calling back
+	if (bSearchInFlight && bSearchingDedicated == bDedicated && Search->SearchState == EOnlineAsyncTaskState::NotStarted)
+	{
+		bSearchInFlight = false;
+		PrintString("Another session search is running, try again once it is done");
+	}
+}
+
+void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(const FName SessionName, const bool bWasSuccessful)
 {
 	if (!bWasSuccessful)
 	{
@@ -112,6 +300,16 @@ void UMultiplayerSessionsSubsystem::OnCreateSessionComplete(const FName SessionN
 	}
 	
 	PrintString(FString::Printf(TEXT("Successfully created a session with name: %s"), *SessionName.ToString()));
+
+	StartAdvertisingLoad();
+
+	// the dedicated server is already running the game map and has no menu to leave
+	if (bIsDedicatedServerSession)
+	{
+		UE_LOG(LogThirdPersonMP, Log, TEXT("Dedicated server session %s is advertised"), *SessionName.ToString());
+		return;
+	}
+
 	GetWorld()->ServerTravel("/Game/ThirdPerson/Lvl_ThirdPerson?listen");
 }
 
@@ -124,6 +322,8 @@ void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(const FName Session
 	}
 	
 	PrintString(FString::Printf(TEXT("Successfully destroyed a session with name: %s"), *SessionName.ToString()));
+
+	StopAdvertisingLoad();
 		
 	if (bCreateServerAfterDestroy)
 	{
@@ -134,63 +334,560 @@ void UMultiplayerSessionsSubsystem::OnDestroySessionComplete(const FName Session
 
 void UMultiplayerSessionsSubsystem::OnFindSessionsComplete(const bool bWasSuccessful)
 {
-	if (!bWasSuccessful)
+	// not our search, or ours is still running
+	const TSharedPtr<FOnlineSessionSearch>& ActiveSearch = bSearchingDedicated ? DedicatedSessionSearch : SessionSearch;
+	if (!bSearchInFlight || !ActiveSearch.IsValid() || ActiveSearch->SearchState == EOnlineAsyncTaskState::InProgress)
+	{
+		return;
+	}
+
+	bSearchInFlight = false;
+
+	if (bWasSuccessful)
+	{
+		bAnySearchSucceeded = true;
+
+		TArray<FOnlineSessionSearchResult>& Results = ActiveSearch->SearchResults;
+
+		const FString Msg = FString::Printf(bSearchingDedicated ? TEXT("Found %d dedicated servers") : TEXT("Found %d sessions"), Results.Num());
+		PrintString(Msg);
+
+		// the results are moved into the cache, drop the empty shells
+		const int32 NumTransferred = Results.Num();
+		const int32 NumKept = MergeSearchResults(Results, !bSearchingDedicated);
+		Results.Reset();
+
+		INC_DWORD_STAT_BY(STAT_SessionResultsTransferred, NumTransferred);
+		INC_DWORD_STAT_BY(STAT_SessionResultsKept, NumKept);
+		UE_LOG(LogThirdPersonMP, Verbose, TEXT("Session search transferred %d results, kept %d"), NumTransferred, NumKept);
+	}
+
+	// subsystems only run one search at a time, search for dedicated servers once the lobbies are in
+	if (!bSearchingDedicated && DedicatedSessionSearch.IsValid())
+	{
+		if (bWasSuccessful)
+		{
+			OnServerListUpdated.Broadcast();
+		}
+
+		StartSearch(DedicatedSessionSearch, true);
+		return;
+	}
+
+	if (!bAnySearchSucceeded)
 	{
 		PrintString("Failed to find sessions");
 		return;
 	}
-	
+
+	// only a full refresh tells which sessions are gone
+	if (!bSearchIsFiltered)
+	{
+		AgeCachedSessions();
+	}
+
+	OnServerListUpdated.Broadcast();
+
+	// a plain refresh, nothing to join
 	if (ServerNameToFind.IsEmpty())
 	{
-		PrintString("ServerNameToFind is empty!");
 		return;
 	}
-	
-	TArray<FOnlineSessionSearchResult> Results = SessionSearch->SearchResults;
-	if (Results.Num() == 0)
+
+	const FString ServerName = ServerNameToFind;
+	ServerNameToFind = "";
+
+	// several hosts can share a name, e.g. a fleet of dedicated servers
+	TArray<FString> Candidates;
+	GetSessionIdsWithName(ServerName, Candidates);
+
+	if (Candidates.Num() == 0)
 	{
-		PrintString("Zero sessions were found");
+		const FString Msg2 = FString::Printf(TEXT("Couldn't find server with name: %s"), *ServerName);
+		PrintString(Msg2);
 		return;
 	}
 
-	const FString Msg = FString::Printf(TEXT("Found %d sessions"), Results.Num());
-	PrintString(Msg);
-	
-	FOnlineSessionSearchResult* CorrectResult = nullptr;
-	
-	for (FOnlineSessionSearchResult Result : Results)
+	const FString Msg3 = FString::Printf(TEXT("Found %d servers with name: %s"), Candidates.Num(), *ServerName);
+	PrintString(Msg3);
+
+	RankAndJoin(MoveTemp(Candidates));
+}
+
+int32 UMultiplayerSessionsSubsystem::MergeSearchResults(TArray<FOnlineSessionSearchResult>& Results, const bool bFromLobbySearch)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MergeSessionResults);
+
+	int32 NumKept = 0;
+
+	for (FOnlineSessionSearchResult& Result : Results)
 	{
 		if (!Result.IsValid())
 		{
 			continue;
 		}
-		
+
+		// update known sessions in place, append new ones
+		FString SessionId = Result.GetSessionIdStr();
+
+		int32 Index = INDEX_NONE;
+		if (const int32* FoundIndex = SessionIdIndices.Find(SessionId))
+		{
+			Index = *FoundIndex;
+		}
+		else
+		{
+			Index = CachedSessions.Num();
+			SessionIdIndices.Add(SessionId, Index);
+
+			CachedSessions.AddDefaulted_GetRef().SessionId = MoveTemp(SessionId);
+		}
+
+		FCachedSession& CachedSession = CachedSessions[Index];
+		CachedSession.Result = MoveTemp(Result);
+		CachedSession.LastSeenSearch = SearchSerial;
+		CachedSession.bIsLobby = bFromLobbySearch;
+
+		// read the name once per result, and re-index it only if it changed
 		FString ServerName = "No-name";
-		Result.Session.SessionSettings.Get(FName("SERVER_NAME"), ServerName);
-			
-		if (!ServerName.Equals(ServerNameToFind))
+		CachedSession.Result.Session.SessionSettings.Get(SETTING_SERVER_NAME, ServerName);
+
+		if (!ServerName.Equals(CachedSession.ServerName))
+		{
+			ServerNameIndices.RemoveSingle(CachedSession.ServerName, Index);
+
+			CachedSession.ServerName = MoveTemp(ServerName);
+			ServerNameIndices.Add(CachedSession.ServerName, Index);
+		}
+
+		if (ServerNameToFind.IsEmpty() || CachedSession.ServerName.Equals(ServerNameToFind))
+		{
+			++NumKept;
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CachedSessions, CachedSessions.Num());
+
+	return NumKept;
+}
+
+void UMultiplayerSessionsSubsystem::AgeCachedSessions()
+{
+	const int32 MaxMissedRefreshes = CVarSessionsMaxMissedRefreshes.GetValueOnGameThread();
+
+	// drop sessions that stopped showing up
+	for (int32 Index = CachedSessions.Num() - 1; Index >= 0; --Index)
+	{
+		FCachedSession& CachedSession = CachedSessions[Index];
+		CachedSession.MissedRefreshes = CachedSession.LastSeenSearch == SearchSerial ? 0 : CachedSession.MissedRefreshes + 1;
+
+		if (CachedSession.MissedRefreshes > MaxMissedRefreshes)
+		{
+			RemoveCachedSession(Index);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_CachedSessions, CachedSessions.Num());
+}
+
+void UMultiplayerSessionsSubsystem::RemoveCachedSession(const int32 Index)
+{
+	const FCachedSession& Removed = CachedSessions[Index];
+
+	SessionIdIndices.Remove(Removed.SessionId);
+
+	ServerNameIndices.RemoveSingle(Removed.ServerName, Index);
+
+	// keep the array compact, and fix up the indices of the session moved into the gap
+	const int32 MovedFromIndex = CachedSessions.Num() - 1;
+	CachedSessions.RemoveAtSwap(Index, EAllowShrinking::No);
+
+	if (CachedSessions.IsValidIndex(Index))
+	{
+		const FCachedSession& Moved = CachedSessions[Index];
+		SessionIdIndices.Add(Moved.SessionId, Index);
+
+		ServerNameIndices.RemoveSingle(Moved.ServerName, MovedFromIndex);
+		ServerNameIndices.Add(Moved.ServerName, Index);
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::JoinCachedServer(const FString& ServerName)
+{
+	TArray<FString> Candidates;
+	GetSessionIdsWithName(ServerName, Candidates);
+	if (Candidates.Num() == 0)
+	{
+		return false;
+	}
+
+	const FString Msg = FString::Printf(TEXT("Found %d servers with name: %s"), Candidates.Num(), *ServerName);
+	PrintString(Msg);
+
+	RankAndJoin(MoveTemp(Candidates));
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::JoinSearchResult(FCachedSession& CachedSession)
+{
+	FOnlineSessionSearchResult& Result = CachedSession.Result;
+
+	// lobby results don't always come back with these set, dedicated servers use neither
+	if (CachedSession.bIsLobby)
+	{
+		Result.Session.SessionSettings.bUsesPresence = true;
+		Result.Session.SessionSettings.bUseLobbiesIfAvailable = true;
+	}
+
+	SessionInterface->JoinSession(0, MySessionName, Result);
+}
+
+int32 UMultiplayerSessionsSubsystem::GetServerListPage(const int32 PageIndex, const int32 PageSize, TArray<FSessionBrowserEntry>& OutEntries) const
+{
+	OutEntries.Reset();
+
+	if (PageIndex < 0 || PageSize <= 0)
+	{
+		return CachedSessions.Num();
+	}
+
+	const int64 First = static_cast<int64>(PageIndex) * PageSize;
+	const int32 Last = static_cast<int32>(FMath::Min<int64>(First + PageSize, CachedSessions.Num()));
+
+	for (int32 Index = static_cast<int32>(FMath::Min<int64>(First, Last)); Index < Last; ++Index)
+	{
+		const FCachedSession& CachedSession = CachedSessions[Index];
+
+		FSessionBrowserEntry& Entry = OutEntries.AddDefaulted_GetRef();
+		Entry.ServerName = CachedSession.ServerName;
+		Entry.SessionId = CachedSession.SessionId;
+		Entry.PingInMs = CachedSession.Result.PingInMs;
+		Entry.NumOpenConnections = CachedSession.Result.Session.NumOpenPublicConnections;
+		Entry.MaxConnections = CachedSession.Result.Session.SessionSettings.NumPublicConnections;
+		Entry.Score = GetSessionScore(CachedSession);
+
+		CachedSession.Result.Session.SessionSettings.Get(SETTING_PLAYER_COUNT, Entry.PlayerCount);
+		CachedSession.Result.Session.SessionSettings.Get(SETTING_AVG_TICK_MS, Entry.AvgTickMs);
+
+		// show the latency we measured over the one the search reported
+		if (CachedSession.MeasuredPingMs != INDEX_NONE)
+		{
+			Entry.PingInMs = CachedSession.MeasuredPingMs;
+		}
+	}
+
+	return CachedSessions.Num();
+}
+
+UMultiplayerSessionsSubsystem::FCachedSession* UMultiplayerSessionsSubsystem::FindCachedSession(const FString& SessionId)
+{
+	const int32* Index = SessionIdIndices.Find(SessionId);
+	return Index ? &CachedSessions[*Index] : nullptr;
+}
+
+void UMultiplayerSessionsSubsystem::GetSessionIdsWithName(const FString& ServerName, TArray<FString>& OutSessionIds) const
+{
+	OutSessionIds.Reset();
+
+	for (auto It = ServerNameIndices.CreateConstKeyIterator(ServerName); It; ++It)
+	{
+		OutSessionIds.Add(CachedSessions[It.Value()].SessionId);
+	}
+}
+
+float UMultiplayerSessionsSubsystem::GetSearchResultScore(const FOnlineSessionSearchResult& Result, const int32 MeasuredPingMs)
+{
+	const FOnlineSession& Session = Result.Session;
+	const int32 PingMs = MeasuredPingMs != INDEX_NONE ? MeasuredPingMs : Result.PingInMs;
+
+	int32 PlayerCount = 0;
+	float AvgTickMs = 0.0f;
+	Session.SessionSettings.Get(SETTING_PLAYER_COUNT, PlayerCount);
+	Session.SessionSettings.Get(SETTING_AVG_TICK_MS, AvgTickMs);
+
+	// a busy or slow host costs like extra latency
+	float Score = PingMs
+		+ AvgTickMs * CVarSessionsTickMsWeight.GetValueOnGameThread()
+		+ PlayerCount * CVarSessionsPlayerCountWeight.GetValueOnGameThread();
+
+	// full hosts can't be joined, rank them last
+	constexpr float FullSessionPenalty = 100000.0f;
+	if (Session.SessionSettings.NumPublicConnections > 0 && Session.NumOpenPublicConnections <= 0)
+	{
+		Score += FullSessionPenalty;
+	}
+
+	return Score;
+}
+
+float UMultiplayerSessionsSubsystem::GetSessionScore(const FCachedSession& CachedSession)
+{
+	return GetSearchResultScore(CachedSession.Result, CachedSession.MeasuredPingMs);
+}
+
+void UMultiplayerSessionsSubsystem::SortSessionIdsByScore(TArray<FString>& SessionIds)
+{
+	// score each session once instead of on every comparison, and drop the ones no longer cached
+	TArray<TPair<float, FString>> ScoredIds;
+	ScoredIds.Reserve(SessionIds.Num());
+
+	for (FString& SessionId : SessionIds)
+	{
+		if (const FCachedSession* CachedSession = FindCachedSession(SessionId))
+		{
+			ScoredIds.Emplace(GetSessionScore(*CachedSession), MoveTemp(SessionId));
+		}
+	}
+
+	ScoredIds.StableSort([](const TPair<float, FString>& A, const TPair<float, FString>& B) { return A.Key < B.Key; });
+
+	SessionIds.Reset();
+	for (TPair<float, FString>& ScoredId : ScoredIds)
+	{
+		SessionIds.Add(MoveTemp(ScoredId.Value));
+	}
+}
+
+void UMultiplayerSessionsSubsystem::PingSearchResults(const IOnlineSessionPtr& Sessions, const TArray<const FOnlineSessionSearchResult*>& Results, TFunction<void(const TArray<int32>&)>&& OnPinged)
+{
+	struct FProbes
+	{
+		TArray<int32> PingsMs;
+		TFunction<void(const TArray<int32>&)> OnPinged;
+
+		// starts at one so the probes can't finish while pings are still being sent
+		int32 NumPending = 1;
+	};
+
+	const int32 NumProbes = FMath::Min(Results.Num(), CVarSessionsPingProbeCount.GetValueOnGameThread());
+	const float Timeout = CVarSessionsPingProbeTimeout.GetValueOnGameThread();
+
+	const TSharedRef<FProbes> Probes = MakeShared<FProbes>();
+	Probes->PingsMs.Init(INDEX_NONE, FMath::Max(NumProbes, 0));
+	Probes->OnPinged = MoveTemp(OnPinged);
+
+	auto FinishProbe = [Probes]()
+	{
+		if (--Probes->NumPending == 0)
+		{
+			Probes->OnPinged(Probes->PingsMs);
+		}
+	};
+
+	// ping all candidates at once, the caller waits for the slowest answer or the timeout
+	for (int32 Index = 0; Index < NumProbes; ++Index)
+	{
+		FString ConnectString;
+		if (!Sessions.IsValid() || !Sessions->GetResolvedConnectString(*Results[Index], NAME_GamePort, ConnectString))
 		{
 			continue;
 		}
-		
-		CorrectResult = &Result;
-		const FString Msg2 = FString::Printf(TEXT("Found server with name: %s"), *ServerName);
-		PrintString(Msg2);
-		break;
+
+		// ping the host, without the game port
+		FString Host = ConnectString;
+		ConnectString.Split(TEXT(":"), &Host, nullptr, ESearchCase::CaseSensitive, ESearchDir::FromEnd);
+
+		INC_DWORD_STAT(STAT_SessionPingProbes);
+		++Probes->NumPending;
+
+		FIcmp::IcmpEcho(Host, Timeout, [Probes, Index, FinishProbe](FIcmpEchoResult Result)
+		{
+			// hosts that drop pings, or can't be reached directly (Steam P2P), are left at INDEX_NONE
+			if (Result.Status == EIcmpResponseStatus::Success)
+			{
+				Probes->PingsMs[Index] = FMath::RoundToInt(Result.Time * 1000.0f);
+			}
+
+			FinishProbe();
+		});
 	}
-	
-	if (CorrectResult == nullptr)
+
+	FinishProbe();
+}
+
+void UMultiplayerSessionsSubsystem::RankSessions(TArray<FString>&& SessionIds, TFunction<void(const TArray<FString>&)>&& OnRanked)
+{
+	// rank by what the search reported first, only the best few are worth pinging
+	SortSessionIdsByScore(SessionIds);
+
+	TArray<const FOnlineSessionSearchResult*> Results;
+	Results.Reserve(SessionIds.Num());
+
+	for (const FString& SessionId : SessionIds)
 	{
-		const FString Msg3 = FString::Printf(TEXT("Couldn't find server with name: %s"), *ServerNameToFind);
-		PrintString(Msg3);
-		
-		ServerNameToFind = "";
+		Results.Add(&FindCachedSession(SessionId)->Result);
+	}
+
+	TWeakObjectPtr<UMultiplayerSessionsSubsystem> WeakThis(this);
+	PingSearchResults(SessionInterface, Results, [WeakThis, SessionIds = MoveTemp(SessionIds), OnRanked = MoveTemp(OnRanked)](const TArray<int32>& PingsMs) mutable
+	{
+		UMultiplayerSessionsSubsystem* This = WeakThis.Get();
+		if (This == nullptr)
+		{
+			return;
+		}
+
+		// hosts that didn't answer keep the ping the search reported
+		for (int32 Index = 0; Index < PingsMs.Num(); ++Index)
+		{
+			FCachedSession* Probed = This->FindCachedSession(SessionIds[Index]);
+			if (Probed && PingsMs[Index] != INDEX_NONE)
+			{
+				Probed->MeasuredPingMs = PingsMs[Index];
+			}
+		}
+
+		This->SortSessionIdsByScore(SessionIds);
+		OnRanked(SessionIds);
+	});
+}
+
+void UMultiplayerSessionsSubsystem::RankAndJoin(TArray<FString>&& SessionIds)
+{
+	const int32 Serial = ++JoinRankSerial;
+
+	// nothing to choose from
+	if (SessionIds.Num() == 1)
+	{
+		if (FCachedSession* CachedSession = FindCachedSession(SessionIds[0]))
+		{
+			JoinSearchResult(*CachedSession);
+		}
 		return;
 	}
-	
-	CorrectResult->Session.SessionSettings.bUsesPresence = true;
-	CorrectResult->Session.SessionSettings.bUseLobbiesIfAvailable = true;
-	SessionInterface->JoinSession(0, MySessionName, *CorrectResult);
+
+	RankSessions(MoveTemp(SessionIds), [this, Serial](const TArray<FString>& RankedIds)
+	{
+		// a newer search is already ranking its own candidates
+		if (Serial != JoinRankSerial || RankedIds.Num() == 0)
+		{
+			return;
+		}
+
+		FCachedSession* Best = FindCachedSession(RankedIds[0]);
+
+		const FString Msg = FString::Printf(TEXT("Joining best ranked server %s, score %.1f"), *Best->SessionId, GetSessionScore(*Best));
+		PrintString(Msg);
+
+		JoinSearchResult(*Best);
+	});
+}
+
+void UMultiplayerSessionsSubsystem::RankServerList()
+{
+	TArray<FString> SessionIds;
+	SessionIds.Reserve(CachedSessions.Num());
+
+	for (const FCachedSession& CachedSession : CachedSessions)
+	{
+		SessionIds.Add(CachedSession.SessionId);
+	}
+
+	RankSessions(MoveTemp(SessionIds), [this](const TArray<FString>&)
+	{
+		SortCachedSessions();
+		OnServerListUpdated.Broadcast();
+	});
+}
+
+void UMultiplayerSessionsSubsystem::SortCachedSessions()
+{
+	TArray<TPair<float, int32>> Order;
+	Order.Reserve(CachedSessions.Num());
+
+	for (int32 Index = 0; Index < CachedSessions.Num(); ++Index)
+	{
+		Order.Emplace(GetSessionScore(CachedSessions[Index]), Index);
+	}
+
+	Order.StableSort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	TArray<FCachedSession> SortedSessions;
+	SortedSessions.Reserve(CachedSessions.Num());
+
+	for (const TPair<float, int32>& Entry : Order)
+	{
+		SortedSessions.Add(MoveTemp(CachedSessions[Entry.Value]));
+	}
+
+	CachedSessions = MoveTemp(SortedSessions);
+
+	SessionIdIndices.Reset();
+	ServerNameIndices.Reset();
+
+	for (int32 Index = 0; Index < CachedSessions.Num(); ++Index)
+	{
+		SessionIdIndices.Add(CachedSessions[Index].SessionId, Index);
+		ServerNameIndices.Add(CachedSessions[Index].ServerName, Index);
+	}
+}
+
+void UMultiplayerSessionsSubsystem::StartAdvertisingLoad()
+{
+	if (LoadTickerHandle.IsValid())
+	{
+		return;
+	}
+
+	LoadWorkSeconds = 0.0;
+	LoadFrames = 0;
+	LoadElapsed = 0.0f;
+
+	LoadTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UMultiplayerSessionsSubsystem::TickLoadAdvertising));
+}
+
+void UMultiplayerSessionsSubsystem::StopAdvertisingLoad()
+{
+	if (LoadTickerHandle.IsValid())
+	{
+		FTSTicker::GetCoreTicker().RemoveTicker(LoadTickerHandle);
+		LoadTickerHandle.Reset();
+	}
+}
+
+bool UMultiplayerSessionsSubsystem::TickLoadAdvertising(const float DeltaTime)
+{
+	// game thread work, without the time spent waiting for the server tick rate
+	LoadWorkSeconds += FMath::Max(0.0, FApp::GetDeltaTime() - FApp::GetIdleTime());
+	++LoadFrames;
+	LoadElapsed += DeltaTime;
+
+	if (LoadElapsed >= CVarSessionsLoadAdvertiseInterval.GetValueOnGameThread())
+	{
+		AdvertiseLoad();
+
+		LoadWorkSeconds = 0.0;
+		LoadFrames = 0;
+		LoadElapsed = 0.0f;
+	}
+
+	return true;
+}
+
+void UMultiplayerSessionsSubsystem::AdvertiseLoad()
+{
+	if (!SessionInterface.IsValid())
+	{
+		return;
+	}
+
+	const FOnlineSessionSettings* CurrentSettings = SessionInterface->GetSessionSettings(MySessionName);
+	if (CurrentSettings == nullptr)
+	{
+		return;
+	}
+
+	const UWorld* World = GetWorld();
+	const AGameModeBase* GameMode = World ? World->GetAuthGameMode() : nullptr;
+
+	const int32 PlayerCount = GameMode ? GameMode->GetNumPlayers() : 0;
+	const float AvgTickMs = LoadFrames > 0 ? static_cast<float>(LoadWorkSeconds * 1000.0 / LoadFrames) : 0.0f;
+
+	FOnlineSessionSettings UpdatedSettings = *CurrentSettings;
+	UpdatedSettings.Set(SETTING_PLAYER_COUNT, PlayerCount, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+	UpdatedSettings.Set(SETTING_AVG_TICK_MS, AvgTickMs, EOnlineDataAdvertisementType::ViaOnlineServiceAndPing);
+
+	SessionInterface->UpdateSession(MySessionName, UpdatedSettings, true);
 }
 
 void UMultiplayerSessionsSubsystem::OnJoinSessionComplete(const FName SessionName, const EOnJoinSessionCompleteResult::Type Result) const
@@ -6,8 +6,51 @@
 #include "Subsystems/GameInstanceSubsystem.h"
 #include "Interfaces/OnlineSessionInterface.h"
 #include "OnlineSessionSettings.h"
+#include "Containers/Ticker.h"
 #include "MultiplayerSessionsSubsystem.generated.h"
 
+// Session setting holding the server's display name (value is string)
+#define SETTING_SERVER_NAME FName(TEXT("SERVER_NAME"))
+
+// Session settings the host periodically advertises its load with (values are int32 and float)
+#define SETTING_PLAYER_COUNT FName(TEXT("PLAYER_COUNT"))
+#define SETTING_AVG_TICK_MS FName(TEXT("AVG_TICK_MS"))
+
+// One row of the server browser
+USTRUCT(BlueprintType)
+struct FSessionBrowserEntry
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	FString ServerName;
+
+	UPROPERTY(BlueprintReadOnly)
+	FString SessionId;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PingInMs = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 NumOpenConnections = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 MaxConnections = 0;
+
+	UPROPERTY(BlueprintReadOnly)
+	int32 PlayerCount = 0;
+
+	// Average game thread time per frame the host advertised
+	UPROPERTY(BlueprintReadOnly)
+	float AvgTickMs = 0.0f;
+
+	// Combined latency and load score, lower is better
+	UPROPERTY(BlueprintReadOnly)
+	float Score = 0.0f;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnSessionBrowserUpdated);
+
 /**
  * 
  */
@@ -35,9 +78,151 @@ public:
 	
 	UFUNCTION(BlueprintCallable)
 	void FindServer(FString ServerName);
+
+	// Searches for sessions and merges them into the server browser cache without joining any of them.
+	UFUNCTION(BlueprintCallable)
+	void RefreshServerList();
+
+	// Joins a session from the server browser cache by name, without searching again. Returns false if it isn't cached.
+	// When several cached sessions share the name, the best ranked one is joined.
+	UFUNCTION(BlueprintCallable)
+	bool JoinCachedServer(const FString& ServerName);
+
+	// Copies one page of the server browser cache into OutEntries. Returns the total number of cached sessions.
+	// OutEntries is reset, not freed, so a menu reusing the same array doesn't allocate per page.
+	UFUNCTION(BlueprintCallable)
+	int32 GetServerListPage(int32 PageIndex, int32 PageSize, TArray<FSessionBrowserEntry>& OutEntries) const;
+
+	UFUNCTION(BlueprintPure)
+	int32 GetNumCachedServers() const { return CachedSessions.Num(); }
+
+	// Pings the best few cached sessions, then sorts the server browser cache by latency and load.
+	// OnServerListUpdated is broadcast once the pings are back.
+	UFUNCTION(BlueprintCallable)
+	void RankServerList();
+
+	// Combined latency and load score of a search result, lower is better.
+	// MeasuredPingMs replaces the ping the search reported, unless it is INDEX_NONE.
+	static float GetSearchResultScore(const FOnlineSessionSearchResult& Result, int32 MeasuredPingMs = INDEX_NONE);
+
+	// Pings the hosts of the first ThirdPersonMP.Sessions.PingProbeCount results concurrently. The results are only read before returning.
+	// OnPinged gets the round trip time of each pinged result in order, INDEX_NONE for hosts that didn't answer.
+	static void PingSearchResults(const IOnlineSessionPtr& Sessions, const TArray<const FOnlineSessionSearchResult*>& Results, TFunction<void(const TArray<int32>&)>&& OnPinged);
+
+	// Broadcast after each search is merged into the server browser cache.
+	UPROPERTY(BlueprintAssignable)
+	FOnSessionBrowserUpdated OnServerListUpdated;
+
+	// Creates an advertised dedicated server session for the map the server booted into.
+	// The session name is read from -ServerName= on the command line. Only valid on dedicated servers.
+	void CreateDedicatedServerSession();
 	
-	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful) const;
+	void OnCreateSessionComplete(FName SessionName, bool bWasSuccessful);
 	void OnDestroySessionComplete(FName SessionName, bool bWasSuccessful);
 	void OnFindSessionsComplete(bool bWasSuccessful);
 	void OnJoinSessionComplete(FName SessionName, EOnJoinSessionCompleteResult::Type Result) const;
+
+private:
+	// A session in the server browser cache
+	struct FCachedSession
+	{
+		FOnlineSessionSearchResult Result;
+		FString SessionId;
+		FString ServerName;
+
+		// Number of full refreshes in a row this session was missing from
+		int32 MissedRefreshes = 0;
+
+		// SearchSerial of the last search that returned this session
+		int32 LastSeenSearch = 0;
+
+		// True for sessions found by the lobby search, false for dedicated servers
+		bool bIsLobby = true;
+
+		// Round trip time measured by pinging the host, INDEX_NONE until it answers
+		int32 MeasuredPingMs = INDEX_NONE;
+	};
+
+	void OnPostLoadMapWithWorld(UWorld* LoadedWorld);
+
+	// Searches for lobbies, then for dedicated servers, reusing the search objects between searches.
+	// When ServerNameToFind is set, the name is pushed into the query so backends that support it only return matches.
+	void StartSessionSearch();
+
+	void StartSearch(const TSharedPtr<FOnlineSessionSearch>& Search, bool bDedicated);
+
+	// Adds new results to the cache and updates known ones in place.
+	// Returns the number of results matching ServerNameToFind, or all valid results if it is empty.
+	int32 MergeSearchResults(TArray<FOnlineSessionSearchResult>& Results, bool bFromLobbySearch);
+
+	// After a full refresh, drops sessions that were missing from a few refreshes in a row
+	void AgeCachedSessions();
+
+	void RemoveCachedSession(int32 Index);
+
+	void JoinSearchResult(FCachedSession& CachedSession);
+
+	FCachedSession* FindCachedSession(const FString& SessionId);
+
+	// Ids of every cached session with this server name
+	void GetSessionIdsWithName(const FString& ServerName, TArray<FString>& OutSessionIds) const;
+
+	// Combined latency and load score of a session, lower is better. Uses the measured ping once there is one.
+	static float GetSessionScore(const FCachedSession& CachedSession);
+
+	// Sorts sessions by score, pings the best few concurrently, then sorts them again with the measured pings.
+	// OnRanked gets the sessions still cached, best first.
+	void RankSessions(TArray<FString>&& SessionIds, TFunction<void(const TArray<FString>&)>&& OnRanked);
+
+	void SortSessionIdsByScore(TArray<FString>& SessionIds);
+
+	// Sorts the cache by score and rebuilds its indices. A name shared by several sessions maps to the best one.
+	void SortCachedSessions();
+
+	// Joins the best ranked of several sessions with the name being searched for
+	void RankAndJoin(TArray<FString>&& SessionIds);
+
+	// Periodically updates the hosted session with the player count and average frame time
+	void StartAdvertisingLoad();
+	void StopAdvertisingLoad();
+	bool TickLoadAdvertising(float DeltaTime);
+	void AdvertiseLoad();
+
+	// Server browser cache, kept compact. Indexed by session id and by server name, which several sessions can share.
+	TArray<FCachedSession> CachedSessions;
+	TMap<FString, int32> SessionIdIndices;
+	TMultiMap<FString, int32> ServerNameIndices;
+
+	// Non-lobby search for dedicated servers, run after the lobby search. Not needed on LAN, which finds both.
+	TSharedPtr<FOnlineSessionSearch> DedicatedSessionSearch;
+
+	// True while the running search is filtered by server name, so its results don't age out the rest of the cache
+	bool bSearchIsFiltered = false;
+
+	// True while the dedicated server search is the one running
+	bool bSearchingDedicated = false;
+
+	bool bAnySearchSucceeded = false;
+
+	// Incremented for every StartSessionSearch
+	int32 SearchSerial = 0;
+
+	// True between starting a search and handling its completion.
+	// The find sessions delegate also fires for searches started by others (the AdvancedSessions Blueprint nodes).
+	bool bSearchInFlight = false;
+
+	// Identifies the latest ranking before a join, so an older one finishing late doesn't join too
+	int32 JoinRankSerial = 0;
+
+	FTSTicker::FDelegateHandle LoadTickerHandle;
+
+	// Load samples since the last advertisement
+	double LoadWorkSeconds = 0.0;
+	int32 LoadFrames = 0;
+	float LoadElapsed = 0.0f;
+
+	// True when the current session was created by a dedicated server. The server is already in the game map, so no travel is needed.
+	bool bIsDedicatedServerSession = false;
+
+	FDelegateHandle PostLoadMapHandle;
 };
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "PlayerTargetSubsystem.h"
+#include "ThirdPersonMP.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+
+DECLARE_CYCLE_STAT(TEXT("Player Target Snapshot"), STAT_PlayerTargetSnapshot, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Player Target Queries"), STAT_PlayerTargetQueries, STATGROUP_ThirdPersonMP);
+
+bool UPlayerTargetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntPoint UPlayerTargetSubsystem::GetCell(const float X, const float Y)
+{
+	return FIntPoint(FMath::FloorToInt32(X / CellSize), FMath::FloorToInt32(Y / CellSize));
+}
+
+void UPlayerTargetSubsystem::UpdateSnapshot()
+{
+	if (SnapshotFrame == GFrameCounter)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_PlayerTargetSnapshot);
+
+	SnapshotFrame = GFrameCounter;
+
+	Pawns.Reset();
+	LocationsX.Reset();
+	LocationsY.Reset();
+	LocationsZ.Reset();
+	Cells.Reset();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (!IsValid(Pawn))
+		{
+			continue;
+		}
+
+		const FVector Location = Pawn->GetActorLocation();
+		const int32 Index = Pawns.Add(Pawn);
+		LocationsX.Add(Location.X);
+		LocationsY.Add(Location.Y);
+		LocationsZ.Add(Location.Z);
+
+		Cells.FindOrAdd(GetCell(Location.X, Location.Y)).Add(Index);
+	}
+}
+
+int32 UPlayerTargetSubsystem::FindNearestPlayerIndex(const FVector& Origin, const float MaxRange, TFunctionRef<bool(int32)> Filter) const
+{
+	const float MaxRangeSquared = MaxRange >= UE_BIG_NUMBER ? UE_BIG_NUMBER : FMath::Square(MaxRange);
+
+	// Candidates within range, sorted by distance below so the filter is tested nearest first
+	TArray<TPair<float, int32>, TInlineAllocator<16>> Candidates;
+
+	const auto AddCandidate = [&](const int32 Index)
+	{
+		const float DistanceSquared = FMath::Square(LocationsX[Index] - Origin.X) + FMath::Square(LocationsY[Index] - Origin.Y) + FMath::Square(LocationsZ[Index] - Origin.Z);
+		if (DistanceSquared <= MaxRangeSquared)
+		{
+			Candidates.Emplace(DistanceSquared, Index);
+		}
+	};
+
+	// Visit the cells overlapping the range, unless there are fewer occupied cells than that
+	const float CellRadius = FMath::CeilToFloat(FMath::Min(MaxRange, UE_BIG_NUMBER) / CellSize);
+	if (FMath::Square(2.0f * CellRadius + 1.0f) > Cells.Num())
+	{
+		for (int32 Index = 0; Index < Pawns.Num(); ++Index)
+		{
+			AddCandidate(Index);
+		}
+	}
+	else
+	{
+		const FIntPoint OriginCell = GetCell(Origin.X, Origin.Y);
+		const int32 CellRadiusInt = FMath::TruncToInt32(CellRadius);
+		for (int32 CellX = OriginCell.X - CellRadiusInt; CellX <= OriginCell.X + CellRadiusInt; ++CellX)
+		{
+			for (int32 CellY = OriginCell.Y - CellRadiusInt; CellY <= OriginCell.Y + CellRadiusInt; ++CellY)
+			{
+				if (const TArray<int32, TInlineAllocator<4>>* Cell = Cells.Find(FIntPoint(CellX, CellY)))
+				{
+					for (const int32 Index : *Cell)
+					{
+						AddCandidate(Index);
+					}
+				}
+			}
+		}
+	}
+
+	Candidates.Sort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	for (const TPair<float, int32>& Candidate : Candidates)
+	{
+		if (Pawns[Candidate.Value].IsValid() && Filter(Candidate.Value))
+		{
+			return Candidate.Value;
+		}
+	}
+
+	return INDEX_NONE;
+}
+
+APawn* UPlayerTargetSubsystem::FindNearestPlayer(const FVector& Origin, const float MaxRange, const bool bRequireVisibility, const AActor* Viewer)
+{
+	UpdateSnapshot();
+	INC_DWORD_STAT(STAT_PlayerTargetQueries);
+
+	const UWorld* World = GetWorld();
+
+	const int32 Index = FindNearestPlayerIndex(Origin, MaxRange, [&](const int32 CandidateIndex)
+	{
+		if (!bRequireVisibility)
+		{
+			return true;
+		}
+
+		const APawn* Candidate = Pawns[CandidateIndex].Get();
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(PlayerTargetVisibility));
+		QueryParams.AddIgnoredActor(Viewer);
+		QueryParams.AddIgnoredActor(Candidate);
+
+		const FVector CandidateLocation(LocationsX[CandidateIndex], LocationsY[CandidateIndex], LocationsZ[CandidateIndex]);
+		return !World->LineTraceTestByChannel(Origin, CandidateLocation, ECC_Visibility, QueryParams);
+	});
+
+	return Index != INDEX_NONE ? Pawns[Index].Get() : nullptr;
+}
+
+void UPlayerTargetSubsystem::FindNearestPlayers(TConstArrayView<FVector> Origins, const float MaxRange, TArray<APawn*>& OutPlayers)
+{
+	UpdateSnapshot();
+	INC_DWORD_STAT_BY(STAT_PlayerTargetQueries, Origins.Num());
+
+	OutPlayers.SetNumUninitialized(Origins.Num());
+
+	for (int32 OriginIndex = 0; OriginIndex < Origins.Num(); ++OriginIndex)
+	{
+		const int32 Index = FindNearestPlayerIndex(Origins[OriginIndex], MaxRange, [](int32) { return true; });
+		OutPlayers[OriginIndex] = Index != INDEX_NONE ? Pawns[Index].Get() : nullptr;
+	}
+}
+
+void UPlayerTargetSubsystem::GetPlayers(TArray<APawn*>& OutPlayers)
+{
+	UpdateSnapshot();
+
+	OutPlayers.Reset(Pawns.Num());
+	for (const TWeakObjectPtr<APawn>& Pawn : Pawns)
+	{
+		if (APawn* ValidPawn = Pawn.Get())
+		{
+			OutPlayers.Add(ValidPawn);
+		}
+	}
+}
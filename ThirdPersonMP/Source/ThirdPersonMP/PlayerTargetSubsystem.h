@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "PlayerTargetSubsystem.generated.h"
+
+class APawn;
+
+/**
+ * Shared target acquisition for AI.
+ * Keeps a snapshot of every player pawn location, rebuilt at most once per frame on the first query, stored as
+ * separate coordinate arrays and bucketed in a uniform 2D grid. AI tasks and EQS contexts ask it for the nearest
+ * (optionally visible) player instead of each polling player 0.
+ */
+UCLASS()
+class THIRDPERSONMP_API UPlayerTargetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	// Size of a grid cell in world units
+	static constexpr float CellSize = 2000.0f;
+
+	// Returns the player pawn nearest to Origin within MaxRange, or nullptr. If bRequireVisibility is set, only players
+	// with an unobstructed visibility trace from Origin are considered. Viewer is ignored by that trace.
+	APawn* FindNearestPlayer(const FVector& Origin, float MaxRange = UE_BIG_NUMBER, bool bRequireVisibility = false, const AActor* Viewer = nullptr);
+
+	// Answers FindNearestPlayer for every origin in one pass over the snapshot. OutPlayers is resized to match Origins.
+	void FindNearestPlayers(TConstArrayView<FVector> Origins, float MaxRange, TArray<APawn*>& OutPlayers);
+
+	// Returns all player pawns in the current snapshot
+	void GetPlayers(TArray<APawn*>& OutPlayers);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Rebuilds the snapshot if it was not built this frame
+	void UpdateSnapshot();
+
+	// Returns the index of the player nearest to Origin within MaxRange, INDEX_NONE if there is none.
+	// Candidates are filtered by the optional predicate, tested in order of distance.
+	int32 FindNearestPlayerIndex(const FVector& Origin, float MaxRange, TFunctionRef<bool(int32)> Filter) const;
+
+	static FIntPoint GetCell(float X, float Y);
+
+	// Player pawns and their locations, one entry per player
+	TArray<TWeakObjectPtr<APawn>> Pawns;
+	TArray<float> LocationsX;
+	TArray<float> LocationsY;
+	TArray<float> LocationsZ;
+
+	// Indices of the players in each occupied grid cell
+	TMap<FIntPoint, TArray<int32, TInlineAllocator<4>>> Cells;
+
+	// Frame the snapshot was built in
+	uint64 SnapshotFrame = MAX_uint64;
+};
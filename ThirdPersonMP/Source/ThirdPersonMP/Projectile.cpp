@@ -10,6 +10,12 @@
 #include "Particles/ParticleSystem.h"
 #include "Kismet/GameplayStatics.h"
 #include "UObject/ConstructorHelpers.h"
+#include "Net/UnrealNetwork.h"
+#include "TimerManager.h"
+#include "ProjectilePoolSubsystem.h"
+#include "ThirdPersonMPCharacter.h"
+#include "LagCompensationSubsystem.h"
+#include "ImpactEventSubsystem.h"
 
 AProjectile::AProjectile()
 {
@@ -70,6 +76,162 @@ AProjectile::AProjectile()
 	// Set damage
 	DamageType = UDamageType::StaticClass();
 	Damage = 10.0f;
+	
+	MaxLifetime = 5.0f;
+	bIsPooled = false;
+	bIsPredicted = false;
+	RewindTime = 0.0;
+	LastTickLocation = FVector::ZeroVector;
+}
+
+void AProjectile::GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	
+	DOREPLIFETIME(AProjectile, Activation);
+}
+
+void AProjectile::ActivateFromPool(const FVector& Location, const FRotator& Rotation, APawn* InstigatorPawn, const uint16 PredictionKey)
+{
+	bIsPooled = true;
+	
+	Activation.Location = Location;
+	Activation.Rotation = Rotation;
+	Activation.InstigatorPawn = InstigatorPawn;
+	Activation.PredictionKey = PredictionKey;
+	++Activation.ActivationCount;
+	Activation.bActive = true;
+	
+	ApplyActivation();
+	ForceNetUpdate();
+	
+	// Remember how far behind the shooter was, so hits can be checked against what it saw
+	RewindTime = 0.0;
+	LastTickLocation = Location;
+	if (const ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>())
+	{
+		const AController* InstigatorController = InstigatorPawn != nullptr ? InstigatorPawn->GetController() : nullptr;
+		RewindTime = GetWorld()->GetTimeSeconds() - LagCompensation->GetClientViewTimestamp(InstigatorController);
+	}
+	
+	// Only the rewound sweep decides pawn hits, otherwise both the current and the rewound pose could be hit
+	SphereComponent->SetCollisionResponseToChannel(ECC_Pawn, RewindTime > 0.0 ? ECR_Ignore : ECR_Block);
+	
+	GetWorld()->GetTimerManager().SetTimer(LifetimeTimer, this, &AProjectile::OnLifetimeExpired, MaxLifetime, false);
+}
+
+void AProjectile::ParkInPool()
+{
+	bIsPooled = true;
+	
+	Activation.InstigatorPawn = nullptr;
+	Activation.PredictionKey = 0;
+	Activation.bActive = false;
+	
+	ApplyActivation();
+	ForceNetUpdate();
+	
+	// Back to the live collision against pawns until the next launch decides again
+	RewindTime = 0.0;
+	SphereComponent->SetCollisionResponseToChannel(ECC_Pawn, ECR_Block);
+	
+	GetWorld()->GetTimerManager().ClearTimer(LifetimeTimer);
+}
+
+void AProjectile::InitializePredicted(const uint16 PredictionKey, const float Timeout)
+{
+	bIsPredicted = true;
+	Activation.PredictionKey = PredictionKey;
+	Activation.InstigatorPawn = GetInstigator();
+	
+	// The prediction is purely cosmetic, it is never sent to the server
+	SetReplicates(false);
+	
+	// If the server never launches the matching projectile, the shot was mispredicted and the local one is removed
+	SetLifeSpan(Timeout);
+}
+
+void AProjectile::TakeOverPredictedProjectile(AProjectile* PredictedProjectile)
+{
+	if (!IsValid(PredictedProjectile))
+	{
+		return;
+	}
+	
+	if (PredictedProjectile->IsActiveInWorld())
+	{
+		// Continue from where the predicted projectile is, which is ahead of the replicated spawn location by the fire latency
+		SetActorLocation(PredictedProjectile->GetActorLocation(), false, nullptr, ETeleportType::ResetPhysics);
+		ProjectileMovementComponent->Velocity = PredictedProjectile->ProjectileMovementComponent->Velocity;
+		ProjectileMovementComponent->UpdateComponentVelocity();
+	}
+	else
+	{
+		// The predicted projectile already exploded, keep the authoritative one out of sight until the server parks it
+		ProjectileMovementComponent->StopMovementImmediately();
+		SetActorEnableCollision(false);
+		SetActorHiddenInGame(true);
+	}
+	
+	PredictedProjectile->Destroy();
+}
+
+void AProjectile::OnRep_Activation()
+{
+	ApplyActivation();
+	
+	// Let the shooter swap its predicted projectile for this one
+	if (Activation.bActive && Activation.PredictionKey != 0)
+	{
+		AThirdPersonMPCharacter* Shooter = Cast<AThirdPersonMPCharacter>(Activation.InstigatorPawn);
+		if (Shooter != nullptr && Shooter->IsLocallyControlled())
+		{
+			Shooter->ReconcilePredictedProjectile(this, Activation.PredictionKey);
+		}
+	}
+}
+
+void AProjectile::ApplyActivation()
+{
+	if (Activation.bActive)
+	{
+		SetInstigator(Activation.InstigatorPawn);
+		SetActorLocationAndRotation(Activation.Location, Activation.Rotation, false, nullptr, ETeleportType::ResetPhysics);
+		SetActorHiddenInGame(false);
+		SetActorEnableCollision(true);
+		
+		// The movement component detaches from its updated component when it stops on a blocking hit
+		ProjectileMovementComponent->SetUpdatedComponent(SphereComponent);
+		ProjectileMovementComponent->Velocity = Activation.Rotation.Vector() * ProjectileMovementComponent->InitialSpeed;
+		ProjectileMovementComponent->UpdateComponentVelocity();
+		ProjectileMovementComponent->SetComponentTickEnabled(true);
+	}
+	else
+	{
+		ProjectileMovementComponent->StopMovementImmediately();
+		ProjectileMovementComponent->SetComponentTickEnabled(false);
+		SetActorEnableCollision(false);
+		SetActorHiddenInGame(true);
+	}
+}
+
+void AProjectile::OnLifetimeExpired()
+{
+	Release();
+}
+
+void AProjectile::Release()
+{
+	if (!bIsPooled)
+	{
+		Destroy();
+		return;
+	}
+	
+	if (UProjectilePoolSubsystem* PoolSubsystem = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+	{
+		PoolSubsystem->ReleaseProjectile(this);
+	}
 }
 
 // Called when the game starts or when spawned
@@ -80,7 +242,12 @@ void AProjectile::BeginPlay()
 
 void AProjectile::Destroyed()
 {
-	MulticastRPCSpawnExplosion();
+	// Pooled projectiles report their impact when it happens, they are only destroyed together with the world.
+	// Predicted projectiles are destroyed when replaced by the server's projectile or on misprediction.
+	if (!bIsPooled && !bIsPredicted && HasAuthority())
+	{
+		AddImpactEvent();
+	}
 	// const FString message = FString::Printf(TEXT("Local role in Destroyed: %d."), GetLocalRole());
 	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
 }
@@ -91,21 +258,54 @@ void AProjectile::OnProjectileImpact(UPrimitiveComponent* HitComponent, AActor*
 {
 	// const FString message = FString::Printf(TEXT("Local role in OnProjectileImpact: %d."), GetLocalRole());
 	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
+	if (!Activation.bActive)
+	{
+		return;
+	}
+	
+	// Predicted projectiles only show the impact, damage is applied by the server's projectile
+	if (bIsPredicted)
+	{
+		SpawnExplosionEffects();
+		
+		if (AThirdPersonMPCharacter* Shooter = Cast<AThirdPersonMPCharacter>(GetInstigator()))
+		{
+			Shooter->MarkPredictedImpactShown(Activation.PredictionKey);
+		}
+		
+		Activation.bActive = false;
+		ApplyActivation();
+		return;
+	}
+	
 	if (OtherActor)
 	{
-		UGameplayStatics::ApplyPointDamage(OtherActor, Damage, NormalImpulse, Hit, GetInstigator()->Controller, this, DamageType);
+		UGameplayStatics::ApplyPointDamage(OtherActor, Damage, NormalImpulse, Hit, GetInstigatorController(), this, DamageType);
+	}
+	
+	if (bIsPooled)
+	{
+		AddImpactEvent();
 	}
 
-	Destroy();
+	Release();
 }
 
-void AProjectile::MulticastRPCSpawnExplosion_Implementation()
+void AProjectile::AddImpactEvent() const
+{
+	if (UImpactEventSubsystem* ImpactEvents = GetWorld()->GetSubsystem<UImpactEventSubsystem>())
+	{
+		ImpactEvents->AddImpactEvent(GetActorLocation(), GetClass(), GetInstigator(), Activation.PredictionKey);
+	}
+}
+
+void AProjectile::SpawnExplosionEffects() const
 {
 	const UWorld* World = GetWorld();
 
 	if (World == nullptr)
 	{
-		UE_LOG(LogThirdPersonMP, Error, TEXT("GetWorld() returned nullptr in AProjectile::MulticastRPCSpawnExplosion_Implementation()"));
+		UE_LOG(LogThirdPersonMP, Error, TEXT("GetWorld() returned nullptr in AProjectile::SpawnExplosionEffects()"));
 		return;
 	}
 
@@ -123,4 +323,32 @@ void AProjectile::MulticastRPCSpawnExplosion_Implementation()
 void AProjectile::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
+	
+	if (HasAuthority() && Activation.bActive && RewindTime > 0.0)
+	{
+		SweepLagCompensated();
+	}
+}
+
+void AProjectile::SweepLagCompensated()
+{
+	const ULagCompensationSubsystem* LagCompensation = GetWorld()->GetSubsystem<ULagCompensationSubsystem>();
+	if (LagCompensation == nullptr)
+	{
+		return;
+	}
+	
+	const FVector CurrentLocation = GetActorLocation();
+	const FVector SweepStart = LastTickLocation;
+	LastTickLocation = CurrentLocation;
+	
+	TArray<FHitResult> RewoundHits;
+	const double Timestamp = GetWorld()->GetTimeSeconds() - RewindTime;
+	if (!LagCompensation->SweepRewound(Timestamp, SweepStart, CurrentLocation, SphereComponent->GetScaledSphereRadius(), GetInstigator(), RewoundHits))
+	{
+		return;
+	}
+	
+	const FHitResult& Hit = RewoundHits[0];
+	OnProjectileImpact(SphereComponent, Hit.GetActor(), Hit.GetComponent(), (CurrentLocation - SweepStart).GetSafeNormal(), Hit);
 }
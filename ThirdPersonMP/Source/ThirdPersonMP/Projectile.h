@@ -6,6 +6,34 @@
 #include "GameFramework/Actor.h"
 #include "Projectile.generated.h"
 
+// Compact replicated state used to launch and park pooled projectiles without respawning them
+USTRUCT()
+struct FProjectileActivation
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FVector_NetQuantize Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	UPROPERTY()
+	TObjectPtr<APawn> InstigatorPawn;
+
+	// Incremented on every launch so that consecutive launches with identical data still trigger OnRep
+	UPROPERTY()
+	uint8 ActivationCount = 0;
+
+	// Key of the client-predicted projectile this launch corresponds to, 0 if the shot was not predicted
+	UPROPERTY()
+	uint16 PredictionKey = 0;
+
+	// Projectiles start active so that instances spawned outside of the pool keep working as before
+	UPROPERTY()
+	bool bActive = true;
+};
+
 UCLASS()
 class THIRDPERSONMP_API AProjectile : public AActor
 {
@@ -44,8 +72,67 @@ public:
 	
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Damage")
 	float Damage;
+	
+	// Time in seconds after which a projectile that did not hit anything is returned to the pool
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Projectile")
+	float MaxLifetime;
+	
+	// Property replication
+	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
+	
+	// Launches a parked projectile from the given transform. Should only be called on the server by UProjectilePoolSubsystem.
+	void ActivateFromPool(const FVector& Location, const FRotator& Rotation, APawn* InstigatorPawn, uint16 PredictionKey);
+	
+	// Turns a locally spawned projectile into a cosmetic, non-replicated prediction of a shot. Should only be called on the owning client.
+	void InitializePredicted(uint16 PredictionKey, float Timeout);
+	
+	// Replaces the matching client-predicted projectile with this authoritative one. Called on the owning client.
+	void TakeOverPredictedProjectile(AProjectile* PredictedProjectile);
+	
+	// Stops, hides and disables the projectile until it is activated again. Should only be called on the server by UProjectilePoolSubsystem.
+	void ParkInPool();
+	
+	FORCEINLINE bool IsActiveInWorld() const { return Activation.bActive; }
 
 protected:
+	// Set on projectiles owned by UProjectilePoolSubsystem, which are parked instead of destroyed
+	bool bIsPooled;
+	
+	// Set on the owning client's local projectiles, which deal no damage and only exist until the server's projectile arrives
+	bool bIsPredicted;
+	
+	// How far in seconds the shooter's view of other characters lags behind the server. Used to check hits against rewound characters on the server.
+	double RewindTime;
+	
+	// Location at the end of the previous tick, start of the next lag compensated sweep
+	FVector LastTickLocation;
+	
+	UPROPERTY(ReplicatedUsing = OnRep_Activation)
+	FProjectileActivation Activation;
+	
+	// Returns the projectile to the pool once MaxLifetime has elapsed
+	FTimerHandle LifetimeTimer;
+	
+	UFUNCTION()
+	void OnRep_Activation();
+	
+	// Applies the current activation state to the components. Runs on the server and on clients.
+	void ApplyActivation();
+	
+	void OnLifetimeExpired();
+	
+	// Returns the projectile to its pool, or destroys it if it was not spawned by the pool
+	void Release();
+	
+	// Spawns the explosion particle and sound at the current location. Does nothing on a dedicated server.
+	void SpawnExplosionEffects() const;
+	
+	// Queues the impact for nearby players through UImpactEventSubsystem. Runs on the server.
+	void AddImpactEvent() const;
+	
+	// Checks the distance travelled this tick against characters as the shooter saw them. Runs on the server.
+	void SweepLagCompensated();
+
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	
@@ -53,7 +140,4 @@ protected:
 	
 	UFUNCTION(Category="Projectile")
 	void OnProjectileImpact(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
-	
-	UFUNCTION(NetMulticast, Unreliable)
-	void MulticastRPCSpawnExplosion();
 };
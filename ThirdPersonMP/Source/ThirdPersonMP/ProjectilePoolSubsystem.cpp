@@ -0,0 +1,131 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ProjectilePoolSubsystem.h"
+#include "Projectile.h"
+#include "ThirdPersonMP.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Pool Hits"), STAT_ProjectilePoolHits, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Projectile Pool Misses"), STAT_ProjectilePoolMisses, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Pooled Projectiles"), STAT_PooledProjectiles, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Parked Projectiles"), STAT_ParkedProjectiles, STATGROUP_ThirdPersonMP);
+
+void UProjectilePoolSubsystem::Deinitialize()
+{
+	for (const TPair<TSubclassOf<AProjectile>, FProjectilePool>& Pair : Pools)
+	{
+		DEC_DWORD_STAT_BY(STAT_PooledProjectiles, Pair.Value.NumCreated);
+		DEC_DWORD_STAT_BY(STAT_ParkedProjectiles, Pair.Value.FreeProjectiles.Num());
+	}
+
+	Pools.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UProjectilePoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UProjectilePoolSubsystem::Prewarm(const TSubclassOf<AProjectile> ProjectileClass, const int32 Count)
+{
+	if (ProjectileClass == nullptr || GetWorld()->GetNetMode() == NM_Client)
+	{
+		return;
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+	while (Pool.NumCreated < Count)
+	{
+		AProjectile* Projectile = SpawnPooledProjectile(ProjectileClass, Pool);
+		if (Projectile == nullptr)
+		{
+			return;
+		}
+
+		Pool.FreeProjectiles.Add(Projectile);
+		INC_DWORD_STAT(STAT_ParkedProjectiles);
+	}
+}
+
+AProjectile* UProjectilePoolSubsystem::AcquireProjectile(const TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, APawn* InstigatorPawn, AActor* OwnerActor, const uint16 PredictionKey)
+{
+	if (ProjectileClass == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("ProjectileClass is nullptr in UProjectilePoolSubsystem::AcquireProjectile()"));
+		return nullptr;
+	}
+
+	FProjectilePool& Pool = Pools.FindOrAdd(ProjectileClass);
+
+	AProjectile* Projectile = nullptr;
+	while (Pool.FreeProjectiles.Num() > 0 && Projectile == nullptr)
+	{
+		// Parked projectiles can be destroyed externally, e.g. by level streaming
+		Projectile = Pool.FreeProjectiles.Pop(EAllowShrinking::No);
+		DEC_DWORD_STAT(STAT_ParkedProjectiles);
+
+		if (!IsValid(Projectile))
+		{
+			Projectile = nullptr;
+			--Pool.NumCreated;
+			DEC_DWORD_STAT(STAT_PooledProjectiles);
+		}
+	}
+
+	if (Projectile != nullptr)
+	{
+		++NumPoolHits;
+		INC_DWORD_STAT(STAT_ProjectilePoolHits);
+	}
+	else
+	{
+		Projectile = SpawnPooledProjectile(ProjectileClass, Pool);
+		if (Projectile == nullptr)
+		{
+			return nullptr;
+		}
+
+		++NumPoolMisses;
+		INC_DWORD_STAT(STAT_ProjectilePoolMisses);
+	}
+
+	Projectile->SetOwner(OwnerActor);
+	Projectile->ActivateFromPool(Location, Rotation, InstigatorPawn, PredictionKey);
+	return Projectile;
+}
+
+void UProjectilePoolSubsystem::ReleaseProjectile(AProjectile* Projectile)
+{
+	if (!IsValid(Projectile) || !Projectile->IsActiveInWorld())
+	{
+		return;
+	}
+
+	Projectile->ParkInPool();
+	Projectile->SetOwner(nullptr);
+
+	Pools.FindOrAdd(Projectile->GetClass()).FreeProjectiles.Add(Projectile);
+	INC_DWORD_STAT(STAT_ParkedProjectiles);
+}
+
+AProjectile* UProjectilePoolSubsystem::SpawnPooledProjectile(const TSubclassOf<AProjectile> ProjectileClass, FProjectilePool& Pool)
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	AProjectile* Projectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, FVector::ZeroVector, FRotator::ZeroRotator, SpawnParameters);
+	if (Projectile == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn pooled projectile in UProjectilePoolSubsystem::SpawnPooledProjectile()"));
+		return nullptr;
+	}
+
+	Projectile->ParkInPool();
+
+	++Pool.NumCreated;
+	INC_DWORD_STAT(STAT_PooledProjectiles);
+	return Projectile;
+}
@@ -0,0 +1,67 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ProjectilePoolSubsystem.generated.h"
+
+class AProjectile;
+
+// Parked projectiles of a single class, ready to be reactivated
+USTRUCT()
+struct FProjectilePool
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<TObjectPtr<AProjectile>> FreeProjectiles;
+
+	// Number of projectiles of this class owned by the pool, parked or in flight
+	int32 NumCreated = 0;
+};
+
+/**
+ * Server-side pool of replicated projectiles.
+ * Projectiles are spawned once, parked on impact and reactivated for the next shot, so their actor channels
+ * stay open and no actor is created or garbage collected per shot.
+ */
+UCLASS()
+class THIRDPERSONMP_API UProjectilePoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Makes sure the pool owns at least Count projectiles of the given class. Should only be called on the server.
+	void Prewarm(TSubclassOf<AProjectile> ProjectileClass, int32 Count);
+
+	// Takes a parked projectile out of the pool (or spawns a new one on a pool miss) and launches it. Should only be called on the server.
+	// PredictionKey identifies the owning client's predicted projectile for this shot, 0 if the shot was not predicted.
+	AProjectile* AcquireProjectile(TSubclassOf<AProjectile> ProjectileClass, const FVector& Location, const FRotator& Rotation, APawn* InstigatorPawn, AActor* OwnerActor, uint16 PredictionKey = 0);
+
+	// Parks the projectile and makes it available for the next AcquireProjectile call
+	void ReleaseProjectile(AProjectile* Projectile);
+
+	UFUNCTION(BlueprintPure, Category="Projectile Pool")
+	int32 GetNumPoolHits() const { return NumPoolHits; }
+
+	UFUNCTION(BlueprintPure, Category="Projectile Pool")
+	int32 GetNumPoolMisses() const { return NumPoolMisses; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	AProjectile* SpawnPooledProjectile(TSubclassOf<AProjectile> ProjectileClass, FProjectilePool& Pool);
+
+	UPROPERTY()
+	TMap<TSubclassOf<AProjectile>, FProjectilePool> Pools;
+
+	// Total number of acquisitions served from parked projectiles
+	int32 NumPoolHits = 0;
+
+	// Total number of acquisitions that had to spawn a new projectile
+	int32 NumPoolMisses = 0;
+};
@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "RankSessionResultsAction.h"
+#include "MultiplayerSessionsSubsystem.h"
+#include "OnlineSubsystem.h"
+
+URankSessionResultsAction* URankSessionResultsAction::RankSessionResults(UObject* WorldContextObject, const TArray<FBlueprintSessionResult>& Results)
+{
+	URankSessionResultsAction* Action = NewObject<URankSessionResultsAction>();
+	Action->Results = Results;
+	Action->RegisterWithGameInstance(WorldContextObject);
+	return Action;
+}
+
+void URankSessionResultsAction::Activate()
+{
+	// rank by what the search reported first, only the best few are worth pinging
+	SortResultsByScore();
+
+	TArray<const FOnlineSessionSearchResult*> SearchResults;
+	SearchResults.Reserve(Results.Num());
+
+	for (const FBlueprintSessionResult& Result : Results)
+	{
+		SearchResults.Add(&Result.OnlineResult);
+	}
+
+	const IOnlineSubsystem* OnlineSubsystem = IOnlineSubsystem::Get();
+	const IOnlineSessionPtr Sessions = OnlineSubsystem ? OnlineSubsystem->GetSessionInterface() : nullptr;
+
+	TWeakObjectPtr<URankSessionResultsAction> WeakThis(this);
+	UMultiplayerSessionsSubsystem::PingSearchResults(Sessions, SearchResults, [WeakThis](const TArray<int32>& PingsMs)
+	{
+		URankSessionResultsAction* This = WeakThis.Get();
+		if (This == nullptr)
+		{
+			return;
+		}
+
+		// hosts that didn't answer keep the ping the search reported
+		for (int32 Index = 0; Index < PingsMs.Num(); ++Index)
+		{
+			if (PingsMs[Index] != INDEX_NONE)
+			{
+				This->Results[Index].OnlineResult.PingInMs = PingsMs[Index];
+			}
+		}
+
+		This->SortResultsByScore();
+		This->OnRanked.Broadcast(This->Results);
+		This->SetReadyToDestroy();
+	});
+}
+
+void URankSessionResultsAction::SortResultsByScore()
+{
+	TArray<TPair<float, int32>> Order;
+	Order.Reserve(Results.Num());
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		Order.Emplace(UMultiplayerSessionsSubsystem::GetSearchResultScore(Results[Index].OnlineResult), Index);
+	}
+
+	Order.StableSort([](const TPair<float, int32>& A, const TPair<float, int32>& B) { return A.Key < B.Key; });
+
+	TArray<FBlueprintSessionResult> SortedResults;
+	SortedResults.Reserve(Results.Num());
+
+	for (const TPair<float, int32>& Entry : Order)
+	{
+		SortedResults.Add(MoveTemp(Results[Entry.Value]));
+	}
+
+	Results = MoveTemp(SortedResults);
+}
@@ -0,0 +1,38 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Kismet/BlueprintAsyncActionBase.h"
+#include "FindSessionsCallbackProxy.h"
+#include "RankSessionResultsAction.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FOnSessionResultsRanked, const TArray<FBlueprintSessionResult>&, Results);
+
+/**
+ * Ranks the results of a Blueprint session search (Find Sessions, Find Sessions Advanced) the way the server browser
+ * ranks its cache: the best few hosts are pinged, then the results are sorted by latency and advertised load.
+ * Measured pings replace the ping the search reported, so the ranked results show them.
+ */
+UCLASS()
+class THIRDPERSONMP_API URankSessionResultsAction : public UBlueprintAsyncActionBase
+{
+	GENERATED_BODY()
+
+public:
+	// Called with the results sorted best first, once the pings are back
+	UPROPERTY(BlueprintAssignable)
+	FOnSessionResultsRanked OnRanked;
+
+	// Pings the best few session hosts and sorts the results by latency and load, best first
+	UFUNCTION(BlueprintCallable, meta = (BlueprintInternalUseOnly = "true", WorldContext = "WorldContextObject"), Category = "Online|Session")
+	static URankSessionResultsAction* RankSessionResults(UObject* WorldContextObject, const TArray<FBlueprintSessionResult>& Results);
+
+	virtual void Activate() override;
+
+private:
+	// Sorts Results by their score, scoring each result once
+	void SortResultsByScore();
+
+	TArray<FBlueprintSessionResult> Results;
+};
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ServerRPCRateLimiterSubsystem.h"
+#include "ThirdPersonMP.h"
+#include "Engine/NetConnection.h"
+#include "Engine/World.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPCs Rejected"), STAT_RPCsRejected, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("RPCs Coalesced"), STAT_RPCsCoalesced, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("RPC Rate Limited Connections"), STAT_RPCRateLimitedConnections, STATGROUP_ThirdPersonMP);
+
+void UServerRPCRateLimiterSubsystem::Deinitialize()
+{
+	DEC_DWORD_STAT_BY(STAT_RPCRateLimitedConnections, ConnectionBuckets.Num());
+	ConnectionBuckets.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UServerRPCRateLimiterSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UServerRPCRateLimiterSubsystem::ConsumeToken(const UNetConnection* Connection, const FName RPCName, const FServerRPCRateLimit& Limit)
+{
+	if (Connection == nullptr)
+	{
+		return true;
+	}
+
+	const double CurrentTime = GetWorld()->GetRealTimeSeconds();
+
+	TMap<FName, FTokenBucket>* Buckets = ConnectionBuckets.Find(Connection);
+	if (Buckets == nullptr)
+	{
+		// New connections are rare, use them as the point to forget the closed ones
+		RemoveClosedConnections();
+
+		Buckets = &ConnectionBuckets.Add(Connection);
+		INC_DWORD_STAT(STAT_RPCRateLimitedConnections);
+	}
+
+	FTokenBucket* Bucket = Buckets->Find(RPCName);
+	if (Bucket == nullptr)
+	{
+		Bucket = &Buckets->Add(RPCName);
+		Bucket->Tokens = Limit.BurstSize;
+		Bucket->LastRefillTime = CurrentTime;
+	}
+
+	if (Limit.bCoalesceWithinFrame && Bucket->LastAcceptedFrame == GFrameCounter)
+	{
+		++NumCoalescedCalls;
+		INC_DWORD_STAT(STAT_RPCsCoalesced);
+		return false;
+	}
+
+	const double ElapsedTime = CurrentTime - Bucket->LastRefillTime;
+	Bucket->Tokens = FMath::Min(Limit.BurstSize, Bucket->Tokens + static_cast<float>(ElapsedTime) * Limit.TokensPerSecond);
+	Bucket->LastRefillTime = CurrentTime;
+
+	if (Bucket->Tokens < 1.0f)
+	{
+		++NumRejectedCalls;
+		INC_DWORD_STAT(STAT_RPCsRejected);
+		UE_LOG(LogThirdPersonMP, Verbose, TEXT("Rejected %s from %s in UServerRPCRateLimiterSubsystem::ConsumeToken()"), *RPCName.ToString(), *Connection->LowLevelGetRemoteAddress());
+		return false;
+	}
+
+	Bucket->Tokens -= 1.0f;
+	Bucket->LastAcceptedFrame = GFrameCounter;
+	return true;
+}
+
+void UServerRPCRateLimiterSubsystem::RemoveClosedConnections()
+{
+	for (auto It = ConnectionBuckets.CreateIterator(); It; ++It)
+	{
+		const UNetConnection* Connection = It.Key().ResolveObjectPtr();
+		if (Connection == nullptr || Connection->GetConnectionState() == USOCK_Closed)
+		{
+			It.RemoveCurrent();
+			DEC_DWORD_STAT(STAT_RPCRateLimitedConnections);
+		}
+	}
+}
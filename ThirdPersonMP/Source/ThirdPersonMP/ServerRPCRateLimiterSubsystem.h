@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ServerRPCRateLimiterSubsystem.generated.h"
+
+class UNetConnection;
+
+// Token bucket settings of a single server RPC
+USTRUCT(BlueprintType)
+struct FServerRPCRateLimit
+{
+	GENERATED_BODY()
+
+	// Tokens added to the bucket per second, i.e. the sustained number of calls per second
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = 0))
+	float TokensPerSecond = 10.0f;
+
+	// Size of the bucket, i.e. the number of calls that can arrive back to back
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, meta = (ClampMin = 1))
+	float BurstSize = 3.0f;
+
+	// If true, further calls arriving in the same server frame as an accepted call are dropped as duplicates without using tokens.
+	// Only for unreliable RPCs: reliable calls bundled into one frame by jitter are all legitimate.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	bool bCoalesceWithinFrame = false;
+};
+
+/**
+ * Server-side token bucket rate limiting of client RPCs, per connection and per RPC.
+ * Server RPC implementations call ConsumeToken first and return early if it fails, so a single client
+ * flooding an RPC cannot spend more than its budget of the server tick.
+ */
+UCLASS()
+class THIRDPERSONMP_API UServerRPCRateLimiterSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Returns true if the RPC received from Connection may be executed. Calls without a connection (e.g. from the listen server's own player) always pass.
+	bool ConsumeToken(const UNetConnection* Connection, FName RPCName, const FServerRPCRateLimit& Limit);
+
+	UFUNCTION(BlueprintPure, Category="RPC Rate Limiter")
+	int32 GetNumRejectedCalls() const { return NumRejectedCalls; }
+
+	UFUNCTION(BlueprintPure, Category="RPC Rate Limiter")
+	int32 GetNumCoalescedCalls() const { return NumCoalescedCalls; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FTokenBucket
+	{
+		float Tokens = 0.0f;
+		double LastRefillTime = 0.0;
+		uint64 LastAcceptedFrame = MAX_uint64;
+	};
+
+	// Removes the buckets of connections that were closed
+	void RemoveClosedConnections();
+
+	TMap<TObjectKey<UNetConnection>, TMap<FName, FTokenBucket>> ConnectionBuckets;
+
+	// Total number of calls rejected because the bucket was empty
+	int32 NumRejectedCalls = 0;
+
+	// Total number of calls dropped as duplicates of a call accepted in the same frame
+	int32 NumCoalescedCalls = 0;
+};
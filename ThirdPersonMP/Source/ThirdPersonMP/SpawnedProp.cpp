@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnedProp.h"
+#include "SpawnedPropManager.h"
+#include "Components/StaticMeshComponent.h"
+#include "TimerManager.h"
+
+ASpawnedProp::ASpawnedProp()
+{
+	bReplicates = true;
+	SetReplicatingMovement(true);
+	SetMobility(EComponentMobility::Movable);
+
+	UStaticMeshComponent* MeshComponent = GetStaticMeshComponent();
+	MeshComponent->SetIsReplicated(true);
+	MeshComponent->BodyInstance.bGenerateWakeEvents = true;
+
+	RestCollapseDelay = 3.0f;
+}
+
+void ASpawnedProp::InitializeProp(ASpawnedPropManager* InManager, const int32 InPropId, UStaticMesh* Mesh, UMaterialInterface* Material)
+{
+	Manager = InManager;
+	PropId = InPropId;
+
+	UStaticMeshComponent* MeshComponent = GetStaticMeshComponent();
+	MeshComponent->SetStaticMesh(Mesh);
+	if (Material != nullptr)
+	{
+		MeshComponent->SetMaterial(0, Material);
+	}
+
+	MeshComponent->OnComponentSleep.AddDynamic(this, &ASpawnedProp::OnBodySleep);
+	MeshComponent->OnComponentWake.AddDynamic(this, &ASpawnedProp::OnBodyWake);
+	MeshComponent->SetSimulatePhysics(true);
+}
+
+void ASpawnedProp::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	GetWorldTimerManager().ClearTimer(CollapseTimer);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASpawnedProp::OnBodySleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	// Nothing changes while the body sleeps, stop considering the actor for replication
+	SetNetDormancy(DORM_DormantAll);
+
+	GetWorldTimerManager().SetTimer(CollapseTimer, this, &ASpawnedProp::CollapseIntoManager, RestCollapseDelay, false);
+}
+
+void ASpawnedProp::OnBodyWake(UPrimitiveComponent* WakingComponent, FName BoneName)
+{
+	GetWorldTimerManager().ClearTimer(CollapseTimer);
+
+	SetNetDormancy(DORM_Awake);
+
+	if (ASpawnedPropManager* PropManager = Manager.Get())
+	{
+		PropManager->TouchProp(this);
+	}
+}
+
+void ASpawnedProp::CollapseIntoManager()
+{
+	if (ASpawnedPropManager* PropManager = Manager.Get())
+	{
+		PropManager->CollapseProp(this);
+	}
+}
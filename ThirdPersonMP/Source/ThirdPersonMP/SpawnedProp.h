@@ -0,0 +1,52 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/StaticMeshActor.h"
+#include "SpawnedProp.generated.h"
+
+class ASpawnedPropManager;
+
+/**
+ * Physics prop spawned at runtime and owned by ASpawnedPropManager.
+ * Only exists as an actor while it is simulating. Its channel goes net dormant as soon as its body falls asleep,
+ * and once it stayed asleep for RestCollapseDelay the manager collapses it into an instance of its resting props.
+ */
+UCLASS()
+class THIRDPERSONMP_API ASpawnedProp : public AStaticMeshActor
+{
+	GENERATED_BODY()
+
+public:
+	ASpawnedProp();
+
+	// Sets up the mesh and starts simulating. Should only be called on the server.
+	void InitializeProp(ASpawnedPropManager* InManager, int32 InPropId, UStaticMesh* Mesh, UMaterialInterface* Material);
+
+	int32 GetPropId() const { return PropId; }
+
+	// Manager sequence number of the last time this prop was spawned or woken up, used for LRU eviction
+	uint32 LastUsed = 0;
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Time in seconds the body has to stay asleep before the prop is collapsed into the manager's instanced mesh
+	UPROPERTY(EditDefaultsOnly, Category="Prop", meta = (ClampMin = 0, Units = "s"))
+	float RestCollapseDelay;
+
+	UFUNCTION()
+	void OnBodySleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
+	UFUNCTION()
+	void OnBodyWake(UPrimitiveComponent* WakingComponent, FName BoneName);
+
+	void CollapseIntoManager();
+
+	TWeakObjectPtr<ASpawnedPropManager> Manager;
+
+	int32 PropId = INDEX_NONE;
+
+	FTimerHandle CollapseTimer;
+};
@@ -0,0 +1,365 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SpawnedPropManager.h"
+#include "SpawnedProp.h"
+#include "Projectile.h"
+#include "ThirdPersonMP.h"
+#include "Components/HierarchicalInstancedStaticMeshComponent.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "Net/UnrealNetwork.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Props"), STAT_ActiveProps, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Resting Props"), STAT_RestingProps, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Props Evicted"), STAT_PropsEvicted, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Props Promoted"), STAT_PropsPromoted, STATGROUP_ThirdPersonMP);
+
+ASpawnedPropManager::ASpawnedPropManager()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	RootComponent = CreateDefaultSubobject<USceneComponent>(TEXT("Root"));
+
+	// Resting props are spread over the whole level, every client needs all of them.
+	// Between changes there is nothing to replicate, RestingProps changes flush the dormancy.
+	bReplicates = true;
+	bAlwaysRelevant = true;
+	NetDormancy = DORM_DormantAll;
+
+	MaxProps = 128;
+	PromotionImpulseScale = 1.0f;
+
+	RestingProps.Owner = this;
+}
+
+void FRestingProp::PreReplicatedRemove(const FRestingPropArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr)
+	{
+		InArraySerializer.Owner->RemoveRestingPropInstance(*this);
+	}
+}
+
+void FRestingProp::PostReplicatedAdd(const FRestingPropArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr)
+	{
+		InArraySerializer.Owner->AddRestingPropInstance(*this);
+	}
+}
+
+void FRestingProp::PostReplicatedChange(const FRestingPropArray& InArraySerializer)
+{
+	if (InArraySerializer.Owner != nullptr)
+	{
+		InArraySerializer.Owner->UpdateRestingPropInstance(*this);
+	}
+}
+
+void ASpawnedPropManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DEC_DWORD_STAT_BY(STAT_ActiveProps, ActiveProps.Num());
+	DEC_DWORD_STAT_BY(STAT_RestingProps, HasAuthority() ? RestingProps.Items.Num() : 0);
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASpawnedPropManager::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(ASpawnedPropManager, RestingProps);
+}
+
+ASpawnedPropManager* ASpawnedPropManager::Get(UWorld* World)
+{
+	if (World == nullptr || World->GetNetMode() == NM_Client)
+	{
+		return nullptr;
+	}
+
+	if (TActorIterator<ASpawnedPropManager> It(World); It)
+	{
+		return *It;
+	}
+
+	ASpawnedPropManager* Manager = World->SpawnActor<ASpawnedPropManager>();
+	if (Manager == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn prop manager in ASpawnedPropManager::Get()"));
+	}
+
+	return Manager;
+}
+
+ASpawnedProp* ASpawnedPropManager::SpawnProp(UStaticMesh* Mesh, UMaterialInterface* Material, const FTransform& Transform)
+{
+	if (Mesh == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Mesh is nullptr in ASpawnedPropManager::SpawnProp()"));
+		return nullptr;
+	}
+
+	while (GetNumProps() >= MaxProps && EvictLeastRecentlyUsed())
+	{
+	}
+
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.Owner = this;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ASpawnedProp* Prop = GetWorld()->SpawnActor<ASpawnedProp>(ASpawnedProp::StaticClass(), Transform, SpawnParameters);
+	if (Prop == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Prop is nullptr in ASpawnedPropManager::SpawnProp()"));
+		return nullptr;
+	}
+
+	Prop->InitializeProp(this, NextPropId++, Mesh, Material);
+	Prop->LastUsed = ++UseSequence;
+	Prop->OnDestroyed.AddDynamic(this, &ASpawnedPropManager::OnActivePropDestroyed);
+
+	ActiveProps.Add(Prop);
+	INC_DWORD_STAT(STAT_ActiveProps);
+	return Prop;
+}
+
+void ASpawnedPropManager::CollapseProp(ASpawnedProp* Prop)
+{
+	if (!IsValid(Prop) || ActiveProps.Remove(Prop) == 0)
+	{
+		return;
+	}
+
+	DEC_DWORD_STAT(STAT_ActiveProps);
+
+	const UStaticMeshComponent* MeshComponent = Prop->GetStaticMeshComponent();
+
+	FRestingProp& RestingProp = RestingProps.Items.AddDefaulted_GetRef();
+	RestingProp.Mesh = MeshComponent->GetStaticMesh();
+	RestingProp.Material = MeshComponent->GetMaterial(0);
+	RestingProp.Location = Prop->GetActorLocation();
+	RestingProp.Rotation = Prop->GetActorRotation();
+	RestingProp.PropId = Prop->GetPropId();
+	RestingProp.LastUsed = Prop->LastUsed;
+	AddRestingPropInstance(RestingProp);
+	RestingProps.MarkItemDirty(RestingProp);
+	INC_DWORD_STAT(STAT_RestingProps);
+
+	Prop->OnDestroyed.RemoveDynamic(this, &ASpawnedPropManager::OnActivePropDestroyed);
+	Prop->Destroy();
+
+	OnRestingPropsChanged();
+}
+
+void ASpawnedPropManager::TouchProp(ASpawnedProp* Prop)
+{
+	if (Prop != nullptr)
+	{
+		Prop->LastUsed = ++UseSequence;
+	}
+}
+
+void ASpawnedPropManager::OnRestingPropsChanged()
+{
+	FlushNetDormancy();
+}
+
+void ASpawnedPropManager::AddRestingPropInstance(FRestingProp& RestingProp)
+{
+	if (RestingProp.Mesh == nullptr || RestingProp.InstanceIndex != INDEX_NONE)
+	{
+		return;
+	}
+
+	RestingProp.ComponentIndex = FindOrAddRestingPropComponent(RestingProp.Mesh, RestingProp.Material);
+	RestingProp.InstanceIndex = RestingPropComponents[RestingProp.ComponentIndex]->AddInstance(FTransform(RestingProp.Rotation, RestingProp.Location), true);
+}
+
+void ASpawnedPropManager::RemoveRestingPropInstance(FRestingProp& RestingProp)
+{
+	const int32 ComponentIndex = RestingProp.ComponentIndex;
+	const int32 InstanceIndex = RestingProp.InstanceIndex;
+	RestingProp.ComponentIndex = INDEX_NONE;
+	RestingProp.InstanceIndex = INDEX_NONE;
+
+	if (!RestingPropComponents.IsValidIndex(ComponentIndex) || InstanceIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	UHierarchicalInstancedStaticMeshComponent* Component = RestingPropComponents[ComponentIndex];
+	const int32 LastInstanceIndex = Component->GetInstanceCount() - 1;
+
+	// Move the last instance into the gap and remove the last one, so no other instance changes index whichever way the component removes
+	if (InstanceIndex != LastInstanceIndex)
+	{
+		// The cap is small, finding the prop shown by the last instance is cheaper than keeping a reverse map in sync
+		for (FRestingProp& MovedProp : RestingProps.Items)
+		{
+			if (MovedProp.ComponentIndex == ComponentIndex && MovedProp.InstanceIndex == LastInstanceIndex)
+			{
+				FTransform LastTransform;
+				Component->GetInstanceTransform(LastInstanceIndex, LastTransform, true);
+				Component->UpdateInstanceTransform(InstanceIndex, LastTransform, true, true, true);
+				MovedProp.InstanceIndex = InstanceIndex;
+				break;
+			}
+		}
+	}
+
+	Component->RemoveInstance(LastInstanceIndex);
+}
+
+void ASpawnedPropManager::UpdateRestingPropInstance(FRestingProp& RestingProp)
+{
+	// Same mesh and material, only the transform changed
+	if (RestingProp.Mesh != nullptr && RestingProp.InstanceIndex != INDEX_NONE
+		&& RestingProp.ComponentIndex == FindOrAddRestingPropComponent(RestingProp.Mesh, RestingProp.Material))
+	{
+		RestingPropComponents[RestingProp.ComponentIndex]->UpdateInstanceTransform(RestingProp.InstanceIndex, FTransform(RestingProp.Rotation, RestingProp.Location), true, true, true);
+		return;
+	}
+
+	RemoveRestingPropInstance(RestingProp);
+	AddRestingPropInstance(RestingProp);
+}
+
+void ASpawnedPropManager::RemoveRestingProp(const int32 Index)
+{
+	RemoveRestingPropInstance(RestingProps.Items[Index]);
+	RestingProps.Items.RemoveAtSwap(Index);
+	RestingProps.MarkArrayDirty();
+	DEC_DWORD_STAT(STAT_RestingProps);
+
+	OnRestingPropsChanged();
+}
+
+int32 ASpawnedPropManager::FindOrAddRestingPropComponent(UStaticMesh* Mesh, UMaterialInterface* Material)
+{
+	for (int32 Index = 0; Index < RestingPropComponents.Num(); ++Index)
+	{
+		const UHierarchicalInstancedStaticMeshComponent* Component = RestingPropComponents[Index];
+		if (Component->GetStaticMesh() == Mesh && (Material == nullptr || Component->GetMaterial(0) == Material))
+		{
+			return Index;
+		}
+	}
+
+	UHierarchicalInstancedStaticMeshComponent* Component = NewObject<UHierarchicalInstancedStaticMeshComponent>(this);
+	Component->SetMobility(EComponentMobility::Movable);
+	Component->SetupAttachment(RootComponent);
+	Component->SetStaticMesh(Mesh);
+	if (Material != nullptr)
+	{
+		Component->SetMaterial(0, Material);
+	}
+	Component->SetCollisionProfileName(UCollisionProfile::BlockAllDynamic_ProfileName);
+
+	if (HasAuthority())
+	{
+		// Needed for hits from simulating bodies, sweeps report hits regardless
+		Component->SetNotifyRigidBodyCollision(true);
+		Component->OnComponentHit.AddDynamic(this, &ASpawnedPropManager::OnRestingPropHit);
+	}
+
+	Component->RegisterComponent();
+
+	return RestingPropComponents.Add(Component);
+}
+
+void ASpawnedPropManager::OnRestingPropHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	// Characters walking on resting props hit them constantly, only projectiles and simulating bodies wake them up
+	const bool bHitByProjectile = OtherActor != nullptr && OtherActor->IsA<AProjectile>();
+	if (!bHitByProjectile && (OtherComp == nullptr || !OtherComp->IsSimulatingPhysics()))
+	{
+		return;
+	}
+
+	const UHierarchicalInstancedStaticMeshComponent* Component = Cast<UHierarchicalInstancedStaticMeshComponent>(HitComponent);
+	if (Component == nullptr)
+	{
+		return;
+	}
+
+	// The hit item is the instance index, each resting prop knows the instance showing it
+	const int32 ComponentIndex = RestingPropComponents.IndexOfByKey(Component);
+	const int32 HitIndex = RestingProps.Items.IndexOfByPredicate([ComponentIndex, &Hit](const FRestingProp& RestingProp)
+	{
+		return RestingProp.ComponentIndex == ComponentIndex && RestingProp.InstanceIndex == Hit.Item;
+	});
+
+	if (ComponentIndex == INDEX_NONE || HitIndex == INDEX_NONE)
+	{
+		return;
+	}
+
+	const FRestingProp RestingProp = RestingProps.Items[HitIndex];
+	RemoveRestingProp(HitIndex);
+
+	ASpawnedProp* Prop = SpawnProp(RestingProp.Mesh, RestingProp.Material, FTransform(RestingProp.Rotation, RestingProp.Location));
+	if (Prop == nullptr)
+	{
+		return;
+	}
+
+	INC_DWORD_STAT(STAT_PropsPromoted);
+
+	if (bHitByProjectile)
+	{
+		Prop->GetStaticMeshComponent()->AddImpulseAtLocation(OtherActor->GetVelocity() * PromotionImpulseScale, Hit.ImpactPoint);
+	}
+}
+
+void ASpawnedPropManager::OnActivePropDestroyed(AActor* DestroyedActor)
+{
+	if (ActiveProps.Remove(Cast<ASpawnedProp>(DestroyedActor)) > 0)
+	{
+		DEC_DWORD_STAT(STAT_ActiveProps);
+	}
+}
+
+bool ASpawnedPropManager::EvictLeastRecentlyUsed()
+{
+	// The cap is small, a linear scan over all props is cheaper to maintain than an ordered structure
+	int32 OldestActiveIndex = INDEX_NONE;
+	uint32 OldestActiveUse = MAX_uint32;
+	for (int32 Index = 0; Index < ActiveProps.Num(); ++Index)
+	{
+		if (IsValid(ActiveProps[Index]) && ActiveProps[Index]->LastUsed < OldestActiveUse)
+		{
+			OldestActiveUse = ActiveProps[Index]->LastUsed;
+			OldestActiveIndex = Index;
+		}
+	}
+
+	int32 OldestRestingIndex = INDEX_NONE;
+	uint32 OldestRestingUse = MAX_uint32;
+	for (int32 Index = 0; Index < RestingProps.Items.Num(); ++Index)
+	{
+		if (RestingProps.Items[Index].LastUsed < OldestRestingUse)
+		{
+			OldestRestingUse = RestingProps.Items[Index].LastUsed;
+			OldestRestingIndex = Index;
+		}
+	}
+
+	if (OldestRestingIndex != INDEX_NONE && OldestRestingUse <= OldestActiveUse)
+	{
+		RemoveRestingProp(OldestRestingIndex);
+		INC_DWORD_STAT(STAT_PropsEvicted);
+		return true;
+	}
+
+	if (OldestActiveIndex != INDEX_NONE)
+	{
+		// OnActivePropDestroyed removes it from ActiveProps
+		ActiveProps[OldestActiveIndex]->Destroy();
+		INC_DWORD_STAT(STAT_PropsEvicted);
+		return true;
+	}
+
+	return false;
+}
@@ -0,0 +1,156 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/Actor.h"
+#include "Net/Serialization/FastArraySerializer.h"
+#include "SpawnedPropManager.generated.h"
+
+class ASpawnedProp;
+class ASpawnedPropManager;
+class UHierarchicalInstancedStaticMeshComponent;
+
+// Compact replicated state of a prop that came to rest
+USTRUCT()
+struct FRestingProp : public FFastArraySerializerItem
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TObjectPtr<UStaticMesh> Mesh;
+
+	UPROPERTY()
+	TObjectPtr<UMaterialInterface> Material;
+
+	UPROPERTY()
+	FVector_NetQuantize10 Location = FVector::ZeroVector;
+
+	UPROPERTY()
+	FRotator Rotation = FRotator::ZeroRotator;
+
+	// Server only
+	int32 PropId = INDEX_NONE;
+
+	// Server only. Manager sequence number of the last time this prop was used, for LRU eviction.
+	uint32 LastUsed = 0;
+
+	// Not replicated. Resting prop component and instance showing this prop, kept up to date by the manager.
+	int32 ComponentIndex = INDEX_NONE;
+	int32 InstanceIndex = INDEX_NONE;
+
+	// Only the changed props' instances are touched on clients
+	void PreReplicatedRemove(const struct FRestingPropArray& InArraySerializer);
+	void PostReplicatedAdd(const struct FRestingPropArray& InArraySerializer);
+	void PostReplicatedChange(const struct FRestingPropArray& InArraySerializer);
+};
+
+USTRUCT()
+struct FRestingPropArray : public FFastArraySerializer
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<FRestingProp> Items;
+
+	UPROPERTY(NotReplicated)
+	TObjectPtr<ASpawnedPropManager> Owner;
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+	{
+		return FFastArraySerializer::FastArrayDeltaSerialize<FRestingProp, FRestingPropArray>(Items, DeltaParms, *this);
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FRestingPropArray> : public TStructOpsTypeTraitsBase2<FRestingPropArray>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+/**
+ * Owns every prop spawned at runtime.
+ * Props that are simulating are full ASpawnedProp actors. Once they come to rest they are collapsed into hierarchical
+ * instanced static meshes, one per mesh and material, driven by a replicated array of compact transforms. Resting props
+ * hit by a projectile or a simulating body are promoted back to actors. The total number of props is capped, the least
+ * recently used prop is evicted when a new one is spawned at the cap.
+ */
+UCLASS()
+class THIRDPERSONMP_API ASpawnedPropManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	ASpawnedPropManager();
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Returns the prop manager of the world, spawning it if needed. Should only be called on the server.
+	static ASpawnedPropManager* Get(UWorld* World);
+
+	// Spawns a simulating prop, evicting the least recently used prop if the cap is reached. Should only be called on the server.
+	ASpawnedProp* SpawnProp(UStaticMesh* Mesh, UMaterialInterface* Material, const FTransform& Transform);
+
+	// Replaces a prop that came to rest with an instance of its mesh. Called by the prop on the server.
+	void CollapseProp(ASpawnedProp* Prop);
+
+	// Marks the prop as recently used. Called by the prop on the server.
+	void TouchProp(ASpawnedProp* Prop);
+
+	UFUNCTION(BlueprintPure, Category="Props")
+	int32 GetNumProps() const { return ActiveProps.Num() + RestingProps.Items.Num(); }
+
+	// Add, remove or move the instance showing a resting prop. Called on the server when RestingProps changes, and by
+	// the replication callbacks of its items on clients.
+	void AddRestingPropInstance(FRestingProp& RestingProp);
+	void RemoveRestingPropInstance(FRestingProp& RestingProp);
+	void UpdateRestingPropInstance(FRestingProp& RestingProp);
+
+protected:
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Maximum number of props, active and resting
+	UPROPERTY(EditDefaultsOnly, Category="Props", meta = (ClampMin = 1))
+	int32 MaxProps;
+
+	// Impulse applied to a promoted prop per unit of the velocity of the projectile that hit it
+	UPROPERTY(EditDefaultsOnly, Category="Props", meta = (ClampMin = 0))
+	float PromotionImpulseScale;
+
+	UPROPERTY(Replicated)
+	FRestingPropArray RestingProps;
+
+	// Props currently simulating as actors. Only valid on the server.
+	UPROPERTY()
+	TArray<TObjectPtr<ASpawnedProp>> ActiveProps;
+
+	// One instanced mesh component per mesh and material pair
+	UPROPERTY()
+	TArray<TObjectPtr<UHierarchicalInstancedStaticMeshComponent>> RestingPropComponents;
+
+	UFUNCTION()
+	void OnRestingPropHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	UFUNCTION()
+	void OnActivePropDestroyed(AActor* DestroyedActor);
+
+	// Returns the index in RestingPropComponents of the component for the mesh and material, creating it if needed
+	int32 FindOrAddRestingPropComponent(UStaticMesh* Mesh, UMaterialInterface* Material);
+
+	// Removes the resting prop at the given index of RestingProps and its instance. Runs on the server.
+	void RemoveRestingProp(int32 Index);
+
+	// Removes the least recently used prop, resting or active. Returns false if there was nothing to remove.
+	bool EvictLeastRecentlyUsed();
+
+	// Wakes the manager for replication after RestingProps changed on the server
+	void OnRestingPropsChanged();
+
+	int32 NextPropId = 0;
+
+	// Incremented whenever a prop is used, orders props for LRU eviction
+	uint32 UseSequence = 0;
+};
@@ -0,0 +1,118 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThinkLODStateTreeAIComponent.h"
+#include "AIThinkLODSubsystem.h"
+#include "AIController.h"
+#include "Engine/World.h"
+
+void UThinkLODStateTreeAIComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	ThinkLOD = GetWorld()->GetSubsystem<UAIThinkLODSubsystem>();
+	if (ThinkLOD)
+	{
+		ThinkLOD->Register(this);
+	}
+}
+
+void UThinkLODStateTreeAIComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	RestorePawnTickInterval();
+
+	if (ThinkLOD)
+	{
+		ThinkLOD->Unregister(this);
+		ThinkLOD = nullptr;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void UThinkLODStateTreeAIComponent::StartLogic()
+{
+	// don't hand time accumulated while stopped to the new run
+	TimeSinceThink = 0.0f;
+
+	Super::StartLogic();
+}
+
+void UThinkLODStateTreeAIComponent::StopLogic(const FString& Reason)
+{
+	// a stopped AI (e.g. a pooled enemy) keeps its pawn's own tick rate
+	RestorePawnTickInterval();
+
+	Super::StopLogic(Reason);
+}
+
+void UThinkLODStateTreeAIComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	TimeSinceThink += DeltaTime;
+
+	if (ThinkLOD && !ThinkLOD->RequestThink(*this))
+	{
+		return;
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+
+	// the StateTree advances by all the time since its last think
+	const float ThinkDeltaTime = TimeSinceThink;
+	TimeSinceThink = 0.0f;
+
+	Super::TickComponent(ThinkDeltaTime, TickType, ThisTickFunction);
+
+	if (ThinkLOD)
+	{
+		ThinkLOD->ReportThink(FPlatformTime::Seconds() - StartTime);
+	}
+}
+
+void UThinkLODStateTreeAIComponent::SetThinkInterval(const float NewThinkInterval, const bool bNewNearPlayer)
+{
+	bNearPlayer = bNewNearPlayer;
+
+	if (ThinkInterval == NewThinkInterval)
+	{
+		return;
+	}
+
+	ThinkInterval = NewThinkInterval;
+
+	// the pawn's own tick follows the same rate while the logic runs, never faster than it was set up to tick
+	APawn* Pawn = IsRunning() ? GetControlledPawn() : nullptr;
+	if (Pawn != ThrottledPawn.Get())
+	{
+		RestorePawnTickInterval();
+
+		if (Pawn)
+		{
+			ThrottledPawn = Pawn;
+			PawnTickInterval = Pawn->GetActorTickInterval();
+		}
+	}
+
+	if (Pawn)
+	{
+		Pawn->SetActorTickInterval(FMath::Max(NewThinkInterval, PawnTickInterval));
+	}
+}
+
+void UThinkLODStateTreeAIComponent::RestorePawnTickInterval()
+{
+	if (APawn* Pawn = ThrottledPawn.Get())
+	{
+		Pawn->SetActorTickInterval(PawnTickInterval);
+	}
+
+	ThrottledPawn.Reset();
+
+	// the next think interval is applied from scratch
+	ThinkInterval = 0.0f;
+}
+
+APawn* UThinkLODStateTreeAIComponent::GetControlledPawn() const
+{
+	return AIOwner ? AIOwner->GetPawn() : nullptr;
+}
@@ -0,0 +1,56 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/StateTreeAIComponent.h"
+#include "ThinkLODStateTreeAIComponent.generated.h"
+
+class UAIThinkLODSubsystem;
+
+/**
+ * StateTree AI component whose ticks are scheduled by UAIThinkLODSubsystem.
+ * Frames it skips are accumulated and passed to the StateTree on its next think.
+ */
+UCLASS()
+class THIRDPERSONMP_API UThinkLODStateTreeAIComponent : public UStateTreeAIComponent
+{
+	GENERATED_BODY()
+
+public:
+	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+	virtual void StartLogic() override;
+	virtual void StopLogic(const FString& Reason) override;
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Sets how often the StateTree thinks and the controlled pawn ticks. 0 thinks every frame.
+	void SetThinkInterval(float NewThinkInterval, bool bNewNearPlayer);
+
+	// Gives the throttled pawn back the tick interval it had before
+	void RestorePawnTickInterval();
+
+	// Returns the pawn controlled by the owning AI controller
+	APawn* GetControlledPawn() const;
+
+	float GetThinkInterval() const { return ThinkInterval; }
+	float GetTimeSinceThink() const { return TimeSinceThink; }
+	bool IsNearPlayer() const { return bNearPlayer; }
+
+private:
+	UPROPERTY(Transient)
+	TObjectPtr<UAIThinkLODSubsystem> ThinkLOD;
+
+	// Seconds between thinks
+	float ThinkInterval = 0.0f;
+
+	// Game time accumulated since the last think
+	float TimeSinceThink = 0.0f;
+
+	// True if a player is close enough that thinks are never deferred
+	bool bNearPlayer = true;
+
+	// Pawn whose tick interval follows the think interval, and its own interval from before
+	TWeakObjectPtr<APawn> ThrottledPawn;
+	float PawnTickInterval = 0.0f;
+};
@@ -21,7 +21,12 @@ public class ThirdPersonMP : ModuleRules
 			"Slate"
 		]);
 
-		PrivateDependencyModuleNames.AddRange([]);
+		PrivateDependencyModuleNames.AddRange([
+			"ReplicationGraph",
+			"NetCore",
+			"SlateCore",
+			"Icmp"
+		]);
 		
 		DynamicallyLoadedModuleNames.Add("OnlineSubsystemSteam");
 
@@ -47,6 +52,7 @@ public class ThirdPersonMP : ModuleRules
 
 		// Uncomment if you are using online features
 		PrivateDependencyModuleNames.Add("OnlineSubsystem");
+		PrivateDependencyModuleNames.Add("OnlineSubsystemUtils");
 
 		// To include OnlineSubsystemSteam, add it to the plugins section in your uproject file with the Enabled attribute set to true
 	}
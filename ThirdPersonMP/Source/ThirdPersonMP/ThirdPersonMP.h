@@ -5,4 +5,7 @@
 #include "CoreMinimal.h"
 
 /** Main log category used across the project */
-DECLARE_LOG_CATEGORY_EXTERN(LogThirdPersonMP, Log, All);
\ No newline at end of file
+DECLARE_LOG_CATEGORY_EXTERN(LogThirdPersonMP, Log, All);
+
+/** Stat group for the project's runtime systems. Use "stat ThirdPersonMP" to display it */
+DECLARE_STATS_GROUP(TEXT("ThirdPersonMP"), STATGROUP_ThirdPersonMP, STATCAT_Advanced);
@@ -1,23 +1,27 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ThirdPersonMPCharacter.h"
+#include "ThirdPersonMPCharacterMovementComponent.h"
 #include "Engine/LocalPlayer.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
-#include "Net/UnrealNetwork.h"
 #include "Engine/Engine.h"
 #include "Projectile.h"
+#include "HealthComponent.h"
+#include "ProjectilePoolSubsystem.h"
 #include "GameFramework/Controller.h"
 #include "EnhancedInputComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "InputActionValue.h"
 #include "ThirdPersonMP.h"
 #include "ThirdPersonMPPlayerController.h"
-#include "Engine/StaticMeshActor.h"
+#include "SpawnedPropManager.h"
+#include "ClientOnlyComponents.h"
 
-AThirdPersonMPCharacter::AThirdPersonMPCharacter()
+AThirdPersonMPCharacter::AThirdPersonMPCharacter(const FObjectInitializer& ObjectInitializer)
+	: Super(ObjectInitializer.SetDefaultSubobjectClass<UThirdPersonMPCharacterMovementComponent>(CharacterMovementComponentName))
 {
 	// Set size for collision capsule
 	GetCapsuleComponent()->InitCapsuleSize(42.f, 96.0f);
@@ -36,28 +40,40 @@ AThirdPersonMPCharacter::AThirdPersonMPCharacter()
 	GetCharacterMovement()->BrakingDecelerationFalling = 1500.0f;
 
 	
+	// Nobody looks through the cameras on a dedicated server, they are stripped in PostInitializeComponents there
+
 	// Create a camera boom (pulls in towards the player if there is a collision)
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
-	CameraBoom->TargetArmLength = 400.0f;
-	CameraBoom->bUsePawnControlRotation = true;
+	CameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
+	if (CameraBoom != nullptr)
+	{
+		CameraBoom->SetupAttachment(RootComponent);
+		CameraBoom->TargetArmLength = 400.0f;
+		CameraBoom->bUsePawnControlRotation = true;
+	}
 	
 	// Create a follow camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
-	FollowCamera->bUsePawnControlRotation = false;
+	FollowCamera = CreateOptionalDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
+	if (FollowCamera != nullptr && CameraBoom != nullptr)
+	{
+		FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+		FollowCamera->bUsePawnControlRotation = false;
+	}
 	
 	// Create first person camera
-	FirstPersonCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
-	FirstPersonCamera->SetupAttachment(GetMesh());
+	FirstPersonCamera = CreateOptionalDefaultSubobject<UCameraComponent>(TEXT("FirstPersonCamera"));
+	if (FirstPersonCamera != nullptr)
+	{
+		FirstPersonCamera->SetupAttachment(GetMesh());
+	}
 	
 	SetThirdPersonCamera();
 	
 	// Note: The skeletal mesh and anim blueprint references on the Mesh component (inherited from Character) 
 	// are set in the derived blueprint asset named ThirdPersonCharacter (to avoid direct content references in C++)
 	
-	MaxHealth = 100.0f;
-	CurrentHealth = MaxHealth;
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComponent"));
+	HealthComponent->MaxHealth = 100.0f;
+	HealthComponent->ReplicationCondition = COND_OwnerOnly;
 	
 	// Initialize projectile class.
 	// This should be set in BP_ThirdPersonMPCharacter
@@ -66,6 +82,37 @@ AThirdPersonMPCharacter::AThirdPersonMPCharacter()
 	// Initialize fire rate.
 	FireRate = 0.15f;
 	bIsFiringWeapon = false;
+	
+	ProjectilePoolSize = 16;
+	PredictedProjectileTimeout = 1.0f;
+	LastProjectilePredictionKey = 0;
+	
+	// Allow a little more than FireRate so legitimate clients are never limited, but a flood of fire RPCs is
+	FServerRPCRateLimit FireRateLimit;
+	FireRateLimit.TokensPerSecond = 1.0f / FireRate + 2.0f;
+	FireRateLimit.BurstSize = 3.0f;
+	ServerRPCRateLimits.Add(GET_FUNCTION_NAME_CHECKED(AThirdPersonMPCharacter, ServerRPCHandleFire), FireRateLimit);
+	
+	// Every spawned static mesh actor is a simulating physics body on the server
+	FServerRPCRateLimit SpawnStaticMeshActorRateLimit;
+	SpawnStaticMeshActorRateLimit.TokensPerSecond = 1.0f;
+	SpawnStaticMeshActorRateLimit.BurstSize = 2.0f;
+	SpawnStaticMeshActorRateLimit.bCoalesceWithinFrame = true;
+	ServerRPCRateLimits.Add(GET_FUNCTION_NAME_CHECKED(AThirdPersonMPCharacter, ServerRPCSpawnStaticMeshActor), SpawnStaticMeshActorRateLimit);
+}
+
+void AThirdPersonMPCharacter::PostLoad()
+{
+	Super::PostLoad();
+	
+#if WITH_EDITORONLY_DATA
+	// Max health used to live on the character, move values saved before that to the health component
+	if (MaxHealth_DEPRECATED >= 0.0f)
+	{
+		HealthComponent->MaxHealth = MaxHealth_DEPRECATED;
+		MaxHealth_DEPRECATED = -1.0f;
+	}
+#endif
 }
 
 // FirstPersonCamera gets attached to the "head" socket of the Mesh component in this method instead of constructor because sockets are not initialized yet in constructor
@@ -73,23 +120,19 @@ void AThirdPersonMPCharacter::PostInitializeComponents()
 {
 	Super::PostInitializeComponents();
 	
-	if (GetMesh())
+	// Every process constructs the cameras, so a dedicated server still pays their construction and destruction for every pawn it spawns
+	if (ClientOnlyComponents::ShouldStrip(this))
 	{
-		TArray<FName> SocketNames = GetMesh()->GetAllSocketNames();
-		UE_LOG(LogThirdPersonMP, Warning, TEXT("Mesh exists obtaining all sockets:"));
-		for (const FName& SocketName : SocketNames)
-		{
-
-			UE_LOG(LogThirdPersonMP, Warning, TEXT("Socket: %s"), *SocketName.ToString());
-		}
-		if (SocketNames.Num() == 0)
-		{
-			UE_LOG(LogThirdPersonMP, Warning, TEXT("No sockets"));
-		}
+		ClientOnlyComponents::Strip(FirstPersonCamera);
+		ClientOnlyComponents::Strip(FollowCamera);
+		ClientOnlyComponents::Strip(CameraBoom);
 	}
-	else
+	
+	ClientOnlyComponents::ReportFootprint(this);
+	
+	if (FirstPersonCamera == nullptr)
 	{
-		UE_LOG(LogThirdPersonMP, Warning, TEXT("No Mesh"));
+		return;
 	}
 	
 	FirstPersonCamera->AttachToComponent(GetMesh(), FAttachmentTransformRules::SnapToTargetIncludingScale, TEXT("head"));
@@ -98,12 +141,20 @@ void AThirdPersonMPCharacter::PostInitializeComponents()
 	FirstPersonCamera->bUsePawnControlRotation = true;
 }
 
-void AThirdPersonMPCharacter::GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const
+void AThirdPersonMPCharacter::BeginPlay()
 {
-	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+	Super::BeginPlay();
 	
-	// Replicate current health
-	DOREPLIFETIME(AThirdPersonMPCharacter, CurrentHealth);
+	HealthComponent->OnHealthChanged.AddDynamic(this, &AThirdPersonMPCharacter::OnHealthChanged);
+	
+	// Pre-warm the projectile pool on the server so the first shots don't spawn actors mid-fight
+	if (HasAuthority())
+	{
+		if (UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>())
+		{
+			ProjectilePool->Prewarm(ProjectileClass, ProjectilePoolSize);
+		}
+	}
 }
 
 void AThirdPersonMPCharacter::StartFire()
@@ -116,7 +167,15 @@ void AThirdPersonMPCharacter::StartFire()
 	bIsFiringWeapon = true;
 	const UWorld* World = GetWorld();
 	World->GetTimerManager().SetTimer(FiringTimer, this, &AThirdPersonMPCharacter::StopFire, FireRate, false);
-	ServerRPCHandleFire();
+	
+	// Remote clients show their own shot right away instead of waiting a round trip for the replicated projectile
+	uint16 PredictionKey = 0;
+	if (!HasAuthority() && IsLocallyControlled())
+	{
+		PredictionKey = SpawnPredictedProjectile();
+	}
+	
+	ServerRPCHandleFire(PredictionKey);
 }
 
 void AThirdPersonMPCharacter::StopFire()
@@ -126,108 +185,166 @@ void AThirdPersonMPCharacter::StopFire()
 
 void AThirdPersonMPCharacter::StartSprint()
 {
-	SetMaxWalkSpeed(this->SprintingMaxWalkSpeed);
-	
-	// if this character has no authority, also start sprinting on server via rpc
-	if (!HasAuthority())
+	if (UThirdPersonMPCharacterMovementComponent* MovementComponent = Cast<UThirdPersonMPCharacterMovementComponent>(GetCharacterMovement()))
 	{
-		// todo: limit server calls with timer?
-		ServerRPCStartSprint();
+		MovementComponent->SetWantsToSprint(true);
 	}
 }
 
 void AThirdPersonMPCharacter::StopSprint()
 {
-	SetMaxWalkSpeed(this->DefaultMaxWalkSpeed);
-	
-	// if this character has no authority, also stop sprinting on server via rpc
-	if (!HasAuthority())
+	if (UThirdPersonMPCharacterMovementComponent* MovementComponent = Cast<UThirdPersonMPCharacterMovementComponent>(GetCharacterMovement()))
 	{
-		// todo: limit server calls with timer?
-		ServerRPCStopSprint();
+		MovementComponent->SetWantsToSprint(false);
 	}
 }
 
-void AThirdPersonMPCharacter::ServerRPCHandleFire_Implementation()
+uint16 AThirdPersonMPCharacter::SpawnPredictedProjectile()
 {
-	// const FString message = FString::Printf(TEXT("Local role in HandleFire: %d."), GetLocalRole());
-	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
-
-	FVector SpawnLocation = GetActorLocation() + (GetActorRotation().Vector()  * 100.0f) + (GetActorUpVector() * 50.0f);
-	FRotator SpawnRotation = GetActorRotation();
+	// 0 is reserved for shots that were not predicted
+	if (++LastProjectilePredictionKey == 0)
+	{
+		++LastProjectilePredictionKey;
+	}
+	
+	// Forget predictions that were mispredicted and have already expired
+	for (auto It = PredictedProjectiles.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+	
+	FVector SpawnLocation;
+	FRotator SpawnRotation;
+	GetProjectileSpawnTransform(SpawnLocation, SpawnRotation);
 	
 	FActorSpawnParameters SpawnParameters;
-	SpawnParameters.Instigator = GetInstigator();
+	SpawnParameters.Instigator = this;
 	SpawnParameters.Owner = this;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	
+	AProjectile* PredictedProjectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, SpawnParameters);
+	if (PredictedProjectile == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn predicted projectile in AThirdPersonMPCharacter::SpawnPredictedProjectile()"));
+		return 0;
+	}
+	
+	PredictedProjectile->InitializePredicted(LastProjectilePredictionKey, PredictedProjectileTimeout);
+	PredictedProjectiles.Add(LastProjectilePredictionKey, PredictedProjectile);
+	
+	return LastProjectilePredictionKey;
+}
 
-	[[maybe_unused]] AProjectile* spawnedProjectile = GetWorld()->SpawnActor<AProjectile>(ProjectileClass, SpawnLocation, SpawnRotation, SpawnParameters);
+void AThirdPersonMPCharacter::ReconcilePredictedProjectile(AProjectile* AuthoritativeProjectile, const uint16 PredictionKey)
+{
+	TWeakObjectPtr<AProjectile> PredictedProjectile;
+	if (!PredictedProjectiles.RemoveAndCopyValue(PredictionKey, PredictedProjectile))
+	{
+		return;
+	}
+	
+	AuthoritativeProjectile->TakeOverPredictedProjectile(PredictedProjectile.Get());
 }
 
+void AThirdPersonMPCharacter::MarkPredictedImpactShown(const uint16 PredictionKey)
+{
+	// Impact events arrive within a round trip, only the last few keys are needed
+	if (ShownPredictedImpacts.Num() >= 16)
+	{
+		ShownPredictedImpacts.RemoveAt(0);
+	}
+	
+	ShownPredictedImpacts.Add(PredictionKey);
+}
 
-void AThirdPersonMPCharacter::ServerRPCStartSprint_Implementation()
+bool AThirdPersonMPCharacter::HasShownPredictedImpact(const uint16 PredictionKey) const
 {
-	// const FString message = FString::Printf(TEXT("Local role in ServerStartSprint: %d."), GetLocalRole());
-	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
-	SetMaxWalkSpeed(SprintingMaxWalkSpeed);
+	return ShownPredictedImpacts.Contains(PredictionKey);
 }
 
-void AThirdPersonMPCharacter::ServerRPCStopSprint_Implementation()
+void AThirdPersonMPCharacter::GetProjectileSpawnTransform(FVector& OutLocation, FRotator& OutRotation) const
 {
-	// const FString message = FString::Printf(TEXT("Local role in ServerStopSprint: %d."), GetLocalRole());
-	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
-	SetMaxWalkSpeed(DefaultMaxWalkSpeed);
+	OutLocation = GetActorLocation() + (GetActorRotation().Vector()  * 100.0f) + (GetActorUpVector() * 50.0f);
+	OutRotation = GetActorRotation();
 }
 
-void AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()
+bool AThirdPersonMPCharacter::ConsumeServerRPCToken(const FName RPCName) const
 {
-	if (StaticMeshToSpawn == nullptr)
+	const FServerRPCRateLimit* Limit = ServerRPCRateLimits.Find(RPCName);
+	if (Limit == nullptr)
 	{
-		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn Static Mesh Actor in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation() as StaticMeshToSpawn is nullptr"));
-		return;
+		return true;
 	}
 	
-	AStaticMeshActor* StaticMeshActor = GetWorld()->SpawnActor<AStaticMeshActor>(AStaticMeshActor::StaticClass());
-	if (StaticMeshActor == nullptr)
+	UServerRPCRateLimiterSubsystem* RateLimiter = GetWorld()->GetSubsystem<UServerRPCRateLimiterSubsystem>();
+	if (RateLimiter == nullptr)
+	{
+		return true;
+	}
+	
+	return RateLimiter->ConsumeToken(GetNetConnection(), RPCName, *Limit);
+}
+
+void AThirdPersonMPCharacter::ServerRPCHandleFire_Implementation(const uint16 PredictionKey)
+{
+	if (!ConsumeServerRPCToken(GET_FUNCTION_NAME_CHECKED(AThirdPersonMPCharacter, ServerRPCHandleFire)))
 	{
-		UE_LOG(LogThirdPersonMP, Error, TEXT("StaticMeshActor is nullptr in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()"));
 		return;
 	}
 	
-	StaticMeshActor->SetReplicates(true);
-	StaticMeshActor->SetReplicateMovement(true);
-	StaticMeshActor->SetMobility(EComponentMobility::Movable);
+	// const FString message = FString::Printf(TEXT("Local role in HandleFire: %d."), GetLocalRole());
+	// GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, message);
+
+	FVector SpawnLocation;
+	FRotator SpawnRotation;
+	GetProjectileSpawnTransform(SpawnLocation, SpawnRotation);
 	
-	// Spawn location set to 300 units in front and 100 units above the current character location
-	FVector SpawnLocation = GetActorLocation() + GetActorRotation().Vector() * 300.0f + GetActorUpVector() * 100.0f;
-	StaticMeshActor->SetActorLocation(SpawnLocation);
+	UProjectilePoolSubsystem* ProjectilePool = GetWorld()->GetSubsystem<UProjectilePoolSubsystem>();
+	if (ProjectilePool == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("ProjectilePool is nullptr in AThirdPersonMPCharacter::ServerRPCHandleFire_Implementation()"));
+		return;
+	}
 
-	UStaticMeshComponent* StaticMeshComponent = StaticMeshActor->GetStaticMeshComponent();
-	if (StaticMeshComponent == nullptr)
+	[[maybe_unused]] AProjectile* spawnedProjectile = ProjectilePool->AcquireProjectile(ProjectileClass, SpawnLocation, SpawnRotation, GetInstigator(), this, PredictionKey);
+}
+
+
+void AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()
+{
+	if (!ConsumeServerRPCToken(GET_FUNCTION_NAME_CHECKED(AThirdPersonMPCharacter, ServerRPCSpawnStaticMeshActor)))
 	{
-		UE_LOG(LogThirdPersonMP, Error, TEXT("StaticMeshComponent is nullptr in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()"));
 		return;
 	}
 	
-	StaticMeshComponent->SetIsReplicated(true);
-	StaticMeshComponent->SetSimulatePhysics(true);
+	if (StaticMeshToSpawn == nullptr)
+	{
+		UE_LOG(LogThirdPersonMP, Error, TEXT("Unable to spawn Static Mesh Actor in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation() as StaticMeshToSpawn is nullptr"));
+		return;
+	}
 	
 	if (StaticMeshMaterial == nullptr)
 	{
 		UE_LOG(LogThirdPersonMP, Error, TEXT("StaticMeshMaterial is nullptr in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()"));
-	} else
+	}
+	
+	ASpawnedPropManager* PropManager = ASpawnedPropManager::Get(GetWorld());
+	if (PropManager == nullptr)
 	{
-		StaticMeshComponent->SetMaterial(0, StaticMeshMaterial);
+		UE_LOG(LogThirdPersonMP, Error, TEXT("PropManager is nullptr in AThirdPersonMPCharacter::ServerRPCSpawnStaticMeshActor_Implementation()"));
+		return;
 	}
 	
-	StaticMeshComponent->SetStaticMesh(StaticMeshToSpawn);
-}
-
-void AThirdPersonMPCharacter::SetMaxWalkSpeed(const float MaxWalkSpeed) const
-{
-	GetCharacterMovement()->MaxWalkSpeed = MaxWalkSpeed;
+	// Spawn location set to 300 units in front and 100 units above the current character location
+	FVector SpawnLocation = GetActorLocation() + GetActorRotation().Vector() * 300.0f + GetActorUpVector() * 100.0f;
+	
+	PropManager->SpawnProp(StaticMeshToSpawn, StaticMeshMaterial, FTransform(SpawnLocation));
 }
 
-void AThirdPersonMPCharacter::OnRep_CurrentHealth() const
+void AThirdPersonMPCharacter::OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth)
 {
 	OnHealthUpdate();
 }
@@ -293,10 +410,10 @@ void AThirdPersonMPCharacter::OnHealthUpdate() const
 	// Client-specific functionality
 	if (IsLocallyControlled())
 	{
-		const FString HealthMessage = FString::Printf(TEXT("You now have %f health remaining."), CurrentHealth);
+		const FString HealthMessage = FString::Printf(TEXT("You now have %f health remaining."), GetCurrentHealth());
 		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Blue, HealthMessage);
 		
-		if (CurrentHealth <= 0)
+		if (GetCurrentHealth() <= 0)
 		{
 			const FString DeathMessage = FString::Printf(TEXT("You have been killed."));
 			GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Red, DeathMessage);
@@ -306,7 +423,7 @@ void AThirdPersonMPCharacter::OnHealthUpdate() const
 	
 	if (HasAuthority())
 	{
-		const FString healthMessage = FString::Printf(TEXT("%s now has %f health remaining."), *GetFName().ToString(), CurrentHealth);
+		const FString healthMessage = FString::Printf(TEXT("%s now has %f health remaining."), *GetFName().ToString(), GetCurrentHealth());
 		GEngine->AddOnScreenDebugMessage(-1, 5.f, FColor::Blue, healthMessage);
 	}
 	
@@ -334,6 +451,11 @@ void AThirdPersonMPCharacter::ToggleMenu()
 
 void AThirdPersonMPCharacter::ToggleCamera()
 {
+	if (FirstPersonCamera == nullptr)
+	{
+		return;
+	}
+	
 	FirstPersonCamera->IsActive() ? SetThirdPersonCamera() : SetFirstPersonCamera();
 }
 
@@ -343,8 +465,11 @@ void AThirdPersonMPCharacter::SetFirstPersonCamera()
 	bUseControllerRotationYaw = true;
 	bUseControllerRotationRoll = true;
 
-	FollowCamera->SetActive(false, true);
-	FirstPersonCamera->SetActive(true, true);
+	if (FollowCamera != nullptr && FirstPersonCamera != nullptr)
+	{
+		FollowCamera->SetActive(false, true);
+		FirstPersonCamera->SetActive(true, true);
+	}
 }
 
 void AThirdPersonMPCharacter::SetThirdPersonCamera()
@@ -354,13 +479,15 @@ void AThirdPersonMPCharacter::SetThirdPersonCamera()
 	bUseControllerRotationYaw = false;
 	bUseControllerRotationRoll = false;
 	
-	FirstPersonCamera->SetActive(false, true);
-	FollowCamera->SetActive(true, true);
+	if (FollowCamera != nullptr && FirstPersonCamera != nullptr)
+	{
+		FirstPersonCamera->SetActive(false, true);
+		FollowCamera->SetActive(true, true);
+	}
 }
 
 void AThirdPersonMPCharacter::SpawnStaticMeshActor()
 {
-	// todo: limit server calls
 	// todo: move spawning to separate class?
 	ServerRPCSpawnStaticMeshActor();
 }
@@ -411,18 +538,26 @@ void AThirdPersonMPCharacter::DoJumpEnd()
 	StopJumping();
 }
 
+float AThirdPersonMPCharacter::GetMaxHealth() const
+{
+	return HealthComponent->GetMaxHealth();
+}
+
+float AThirdPersonMPCharacter::GetCurrentHealth() const
+{
+	return HealthComponent->GetHealth();
+}
+
 void AThirdPersonMPCharacter::SetCurrentHealth(const float HealthValue)
 {
 	if (HasAuthority())
 	{ 
-		CurrentHealth = FMath::Clamp(HealthValue, 0.0f, MaxHealth);
-		OnHealthUpdate();
+		HealthComponent->SetHealth(HealthValue);
 	}
 }
 
 float AThirdPersonMPCharacter::TakeDamage(const float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser)
 {
-	const float NewHealth = CurrentHealth - DamageAmount;
-	SetCurrentHealth(NewHealth);
-	return NewHealth;
+	HealthComponent->ApplyDamage(DamageAmount);
+	return GetCurrentHealth();
 }
@@ -5,10 +5,13 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "Logging/LogMacros.h"
+#include "ServerRPCRateLimiterSubsystem.h"
 #include "ThirdPersonMPCharacter.generated.h"
 
 class USpringArmComponent;
 class UCameraComponent;
+class AProjectile;
+class UHealthComponent;
 class UInputAction;
 struct FInputActionValue;
 
@@ -24,13 +27,14 @@ class AThirdPersonMPCharacter : public ACharacter
 	GENERATED_BODY()
 
 public:
-	AThirdPersonMPCharacter();
+	AThirdPersonMPCharacter(const FObjectInitializer& ObjectInitializer);
+	
+	virtual void PostLoad() override;
 	
 	virtual void PostInitializeComponents() override;
 	
-	// Property replication
-	virtual void GetLifetimeReplicatedProps(TArray<class FLifetimeProperty>& OutLifetimeProps) const override;
-		
+	virtual void BeginPlay() override;
+	
 	// Handles move inputs from either controls or UI interfaces
 	UFUNCTION(BlueprintCallable, Category="Input")
 	virtual void DoMove(float Right, float Forward);
@@ -55,21 +59,30 @@ public:
 	
 	// Getter for max health
 	UFUNCTION(BlueprintPure, Category="Health")
-	FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
+	float GetMaxHealth() const;
 	
 	// Getter for current health
 	UFUNCTION(BlueprintPure, Category="Health")
-	FORCEINLINE float GetCurrentHealth() const { return CurrentHealth; }
+	float GetCurrentHealth() const;
 	
-	// Setter for current health. Clamps the value between 0 nad MaxHealth and calls OnHealthUpdate. Should only be called on the server.
+	// Setter for current health. Clamps the value between 0 and MaxHealth, OnHealthUpdate is called at the end of the frame. Should only be called on the server.
 	UFUNCTION(BlueprintCallable, Category="Health")
 	void SetCurrentHealth(float HealthValue);
 	
 	UFUNCTION(BlueprintCallable, Category="Health")
 	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+	
+	// Swaps the predicted projectile with the given key for the authoritative projectile that replicated from the server. Called on the owning client.
+	void ReconcilePredictedProjectile(AProjectile* AuthoritativeProjectile, uint16 PredictionKey);
+	
+	// Remembers that the predicted projectile with the given key showed its explosion, so the server's impact event is not played again
+	void MarkPredictedImpactShown(uint16 PredictionKey);
+	
+	// Returns true if the predicted projectile with the given key already showed its explosion on this client
+	bool HasShownPredictedImpact(uint16 PredictionKey) const;
 
 private:
-	// Camera boom positioning the camera behind the character
+	// Camera boom positioning the camera behind the character. Cameras are client-only and are null on dedicated servers
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	TObjectPtr<USpringArmComponent> CameraBoom;
 
@@ -80,9 +93,12 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	TObjectPtr<UCameraComponent> FirstPersonCamera;
 	
+	// Health, only replicated to the owning client which is the only one showing it
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	TObjectPtr<UHealthComponent> HealthComponent;
+	
 protected:
 	static constexpr float DefaultMaxWalkSpeed = 500.0f;
-	static constexpr float SprintingMaxWalkSpeed = 850.0f;
 
 	// Jump Input Action
 	UPROPERTY(EditAnywhere, Category="Input")
@@ -117,19 +133,34 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Input")
 	TObjectPtr<UInputAction> SpawnStaticMeshActorAction;
 	
-	UPROPERTY(EditDefaultsOnly, Category="Health")
-	float MaxHealth;
-	
-	UPROPERTY(ReplicatedUsing = OnRep_CurrentHealth)
-	float CurrentHealth;
+#if WITH_EDITORONLY_DATA
+	// Max health saved before it moved to the health component, copied to it in PostLoad. Negative when unset.
+	UPROPERTY()
+	float MaxHealth_DEPRECATED = -1.0f;
+#endif
 	
 	UPROPERTY(EditDefaultsOnly, Category="Gameplay|Projectile")
 	TSubclassOf<class AProjectile> ProjectileClass;
 	
+	// Time in seconds a predicted projectile waits for the server's projectile before it is treated as a misprediction and removed
+	UPROPERTY(EditDefaultsOnly, Category="Gameplay|Projectile", meta = (ClampMin = 0, Units = "s"))
+	float PredictedProjectileTimeout;
+	
+	// Number of projectiles the server keeps parked in the projectile pool for ProjectileClass. The pool grows on demand past this size.
+	UPROPERTY(EditDefaultsOnly, Category="Gameplay|Projectile", meta = (ClampMin = 0))
+	int32 ProjectilePoolSize;
+	
 	// Delay between shots in seconds. Used to control fire rate for your test projectile, but also to prevent an overflow of server functions from binding SpawnProjectile directly to input.
 	UPROPERTY(EditDefaultsOnly, Category="Gameplay")
 	float FireRate;
 	
+	// Token bucket limits of the server RPCs of this character, by RPC name. RPCs without an entry are not limited.
+	UPROPERTY(EditDefaultsOnly, Category="Networking")
+	TMap<FName, FServerRPCRateLimit> ServerRPCRateLimits;
+	
+	// Returns true if the server RPC with the given name may run for this character's connection, according to ServerRPCRateLimits
+	bool ConsumeServerRPCToken(FName RPCName) const;
+	
 	// If true, character is in process of firing projectiles.
 	bool bIsFiringWeapon;
 	
@@ -147,32 +178,40 @@ protected:
 	UFUNCTION(BlueprintCallable, Category="Gameplay")
 	void StopFire();
 	
-	// Server function for spawning projectiles.
+	// Server function for spawning projectiles. PredictionKey identifies the projectile the client predicted for this shot, 0 if none.
 	UFUNCTION(Server, Reliable)
-	void ServerRPCHandleFire();
+	void ServerRPCHandleFire(uint16 PredictionKey);
+	
+	// Returns the transform new projectiles are launched from
+	void GetProjectileSpawnTransform(FVector& OutLocation, FRotator& OutRotation) const;
+	
+	// Spawns a local projectile on the owning client so the shot is visible without waiting for the server. Returns its prediction key.
+	uint16 SpawnPredictedProjectile();
+	
+	// Predicted projectiles waiting for their authoritative counterpart, by prediction key. Only used on the owning client.
+	TMap<uint16, TWeakObjectPtr<AProjectile>> PredictedProjectiles;
+	
+	// Last prediction key handed out by SpawnPredictedProjectile
+	uint16 LastProjectilePredictionKey;
+	
+	// Prediction keys of the last predicted projectiles that exploded locally, oldest first. Only used on the owning client.
+	TArray<uint16> ShownPredictedImpacts;
 	
+	// Sprint input is predicted by UThirdPersonMPCharacterMovementComponent and sent to the server with the character's moves
 	UFUNCTION(BlueprintCallable, Category="Gameplay")
 	void StartSprint();
 	
 	UFUNCTION(BlueprintCallable, Category="Gameplay")
 	void StopSprint();
 	
-	UFUNCTION(Server, Reliable)
-	void ServerRPCStartSprint();
-	
-	UFUNCTION(Server, Reliable)
-	void ServerRPCStopSprint();
-	
 	UFUNCTION(Server, Unreliable)
 	void ServerRPCSpawnStaticMeshActor();
 	
-	void SetMaxWalkSpeed(float MaxWalkSpeed) const;
-	
 	// A timer handle used for providing the fire rate delay in-between spawns.
 	FTimerHandle FiringTimer;
 	
 	UFUNCTION()
-	void OnRep_CurrentHealth() const;
+	void OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth);
 
 	// Initialize input action bindings
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
@@ -183,7 +222,7 @@ protected:
 	// Called for looking input
 	void Look(const FInputActionValue& Value);
 	
-	// Response to health being updated. Called on the server immediately after modification, and on clients in response to a RepNotify
+	// Response to health being updated. Called on the server at the end of the frame health was modified in, and on clients in response to a RepNotify
 	void OnHealthUpdate() const;
 	
 	void ToggleMenu();
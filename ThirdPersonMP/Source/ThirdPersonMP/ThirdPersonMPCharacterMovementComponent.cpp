@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThirdPersonMPCharacterMovementComponent.h"
+#include "ThirdPersonMP.h"
+#include "GameFramework/Character.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Movement Corrections Sent"), STAT_MovementCorrectionsSent, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Movement Corrections Total"), STAT_MovementCorrectionsTotal, STATGROUP_ThirdPersonMP);
+
+UThirdPersonMPCharacterMovementComponent::UThirdPersonMPCharacterMovementComponent()
+{
+	SprintMaxWalkSpeed = 850.0f;
+	bWantsToSprint = false;
+}
+
+float UThirdPersonMPCharacterMovementComponent::GetMaxSpeed() const
+{
+	if (IsSprinting())
+	{
+		return SprintMaxWalkSpeed;
+	}
+
+	return Super::GetMaxSpeed();
+}
+
+bool UThirdPersonMPCharacterMovementComponent::IsSprinting() const
+{
+	return bWantsToSprint && IsMovingOnGround() && !IsCrouching();
+}
+
+void UThirdPersonMPCharacterMovementComponent::SetWantsToSprint(const bool bInWantsToSprint)
+{
+	bWantsToSprint = bInWantsToSprint;
+}
+
+void UThirdPersonMPCharacterMovementComponent::UpdateFromCompressedFlags(const uint8 Flags)
+{
+	Super::UpdateFromCompressedFlags(Flags);
+
+	bWantsToSprint = (Flags & FSavedMove_Character::FLAG_Custom_0) != 0;
+}
+
+bool UThirdPersonMPCharacterMovementComponent::ClientUpdatePositionAfterServerUpdate()
+{
+	// Replaying the saved moves applies their recorded sprint input, keep the current one for the next move
+	const bool bRealWantsToSprint = bWantsToSprint;
+	const bool bResult = Super::ClientUpdatePositionAfterServerUpdate();
+	bWantsToSprint = bRealWantsToSprint;
+
+	return bResult;
+}
+
+bool UThirdPersonMPCharacterMovementComponent::ServerCheckClientError(const float ClientTimeStamp, const float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, const FName ClientBaseBoneName, const uint8 ClientMovementMode)
+{
+	const bool bNeedsCorrection = Super::ServerCheckClientError(ClientTimeStamp, DeltaTime, Accel, ClientLoc, RelativeClientLoc, ClientMovementBase, ClientBaseBoneName, ClientMovementMode);
+	if (bNeedsCorrection)
+	{
+		++NumServerCorrections;
+		INC_DWORD_STAT(STAT_MovementCorrectionsSent);
+		INC_DWORD_STAT(STAT_MovementCorrectionsTotal);
+	}
+
+	return bNeedsCorrection;
+}
+
+FNetworkPredictionData_Client* UThirdPersonMPCharacterMovementComponent::GetPredictionData_Client() const
+{
+	if (ClientPredictionData == nullptr)
+	{
+		UThirdPersonMPCharacterMovementComponent* MutableThis = const_cast<UThirdPersonMPCharacterMovementComponent*>(this);
+		MutableThis->ClientPredictionData = new FNetworkPredictionData_Client_ThirdPersonMP(*this);
+	}
+
+	return ClientPredictionData;
+}
+
+void FSavedMove_ThirdPersonMP::Clear()
+{
+	Super::Clear();
+
+	bSavedWantsToSprint = false;
+}
+
+uint8 FSavedMove_ThirdPersonMP::GetCompressedFlags() const
+{
+	uint8 Result = Super::GetCompressedFlags();
+
+	if (bSavedWantsToSprint)
+	{
+		Result |= FLAG_Custom_0;
+	}
+
+	return Result;
+}
+
+bool FSavedMove_ThirdPersonMP::CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, const float MaxDelta) const
+{
+	// Moves with a different sprint input run at a different speed and can't be sent as one
+	if (bSavedWantsToSprint != static_cast<FSavedMove_ThirdPersonMP*>(NewMove.Get())->bSavedWantsToSprint)
+	{
+		return false;
+	}
+
+	return Super::CanCombineWith(NewMove, InCharacter, MaxDelta);
+}
+
+void FSavedMove_ThirdPersonMP::SetMoveFor(ACharacter* C, const float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData)
+{
+	Super::SetMoveFor(C, InDeltaTime, NewAccel, ClientData);
+
+	if (const UThirdPersonMPCharacterMovementComponent* MovementComponent = Cast<UThirdPersonMPCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		bSavedWantsToSprint = MovementComponent->bWantsToSprint;
+	}
+}
+
+void FSavedMove_ThirdPersonMP::PrepMoveFor(ACharacter* C)
+{
+	Super::PrepMoveFor(C);
+
+	// Replayed moves have to use the sprint input they were originally performed with
+	if (UThirdPersonMPCharacterMovementComponent* MovementComponent = Cast<UThirdPersonMPCharacterMovementComponent>(C->GetCharacterMovement()))
+	{
+		MovementComponent->bWantsToSprint = bSavedWantsToSprint;
+	}
+}
+
+FNetworkPredictionData_Client_ThirdPersonMP::FNetworkPredictionData_Client_ThirdPersonMP(const UCharacterMovementComponent& ClientMovement)
+	: Super(ClientMovement)
+{
+}
+
+FSavedMovePtr FNetworkPredictionData_Client_ThirdPersonMP::AllocateNewMove()
+{
+	return FSavedMovePtr(new FSavedMove_ThirdPersonMP());
+}
@@ -0,0 +1,74 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "ThirdPersonMPCharacterMovementComponent.generated.h"
+
+/**
+ * Character movement with a predicted sprint.
+ * The sprint input is sent to the server with every saved move (as a compressed custom flag), so the owning client
+ * and the server apply the sprint speed on the same move and replays after a correction use the same speed.
+ */
+UCLASS()
+class THIRDPERSONMP_API UThirdPersonMPCharacterMovementComponent : public UCharacterMovementComponent
+{
+	GENERATED_BODY()
+
+public:
+	UThirdPersonMPCharacterMovementComponent();
+
+	virtual float GetMaxSpeed() const override;
+	virtual FNetworkPredictionData_Client* GetPredictionData_Client() const override;
+
+	// Sets the sprint input. Should be called on the locally controlled character, the server receives it with the next move.
+	void SetWantsToSprint(bool bInWantsToSprint);
+
+	UFUNCTION(BlueprintPure, Category="Character Movement: Walking")
+	bool IsSprinting() const;
+
+	// Number of moves from the owning client the server had to correct. Only counted on the server.
+	UFUNCTION(BlueprintPure, Category="Character Movement: Networking")
+	int32 GetNumServerCorrections() const { return NumServerCorrections; }
+
+	// Max walk speed while sprinting
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Character Movement: Walking", meta = (ClampMin = 0, Units = "cm/s"))
+	float SprintMaxWalkSpeed;
+
+	// Sprint input of the move being performed
+	uint8 bWantsToSprint : 1;
+
+protected:
+	virtual void UpdateFromCompressedFlags(uint8 Flags) override;
+	virtual bool ClientUpdatePositionAfterServerUpdate() override;
+	virtual bool ServerCheckClientError(float ClientTimeStamp, float DeltaTime, const FVector& Accel, const FVector& ClientLoc, const FVector& RelativeClientLoc, UPrimitiveComponent* ClientMovementBase, FName ClientBaseBoneName, uint8 ClientMovementMode) override;
+
+private:
+	int32 NumServerCorrections = 0;
+};
+
+// Saved move carrying the sprint input
+class FSavedMove_ThirdPersonMP : public FSavedMove_Character
+{
+public:
+	typedef FSavedMove_Character Super;
+
+	virtual void Clear() override;
+	virtual uint8 GetCompressedFlags() const override;
+	virtual bool CanCombineWith(const FSavedMovePtr& NewMove, ACharacter* InCharacter, float MaxDelta) const override;
+	virtual void SetMoveFor(ACharacter* C, float InDeltaTime, FVector const& NewAccel, FNetworkPredictionData_Client_Character& ClientData) override;
+	virtual void PrepMoveFor(ACharacter* C) override;
+
+	uint8 bSavedWantsToSprint : 1 = 0;
+};
+
+class FNetworkPredictionData_Client_ThirdPersonMP : public FNetworkPredictionData_Client_Character
+{
+public:
+	typedef FNetworkPredictionData_Client_Character Super;
+
+	explicit FNetworkPredictionData_Client_ThirdPersonMP(const UCharacterMovementComponent& ClientMovement);
+
+	virtual FSavedMovePtr AllocateNewMove() override;
+};
@@ -1,8 +1,15 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "ThirdPersonMPGameMode.h"
+#include "ClientOnlyComponents.h"
 
 AThirdPersonMPGameMode::AThirdPersonMPGameMode()
 {
 	// stub
 }
+
+APawn* AThirdPersonMPGameMode::SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform)
+{
+	SCOPE_CYCLE_COUNTER(STAT_CharacterSpawn);
+	return Super::SpawnDefaultPawnAtTransform_Implementation(NewPlayer, SpawnTransform);
+}
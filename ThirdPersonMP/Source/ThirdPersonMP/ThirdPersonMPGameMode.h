@@ -18,6 +18,9 @@ public:
 	
 	/** Constructor */
 	AThirdPersonMPGameMode();
+
+	/** Spawns the player pawn, measured by the Character Spawn stat */
+	virtual APawn* SpawnDefaultPawnAtTransform_Implementation(AController* NewPlayer, const FTransform& SpawnTransform) override;
 };
 
 
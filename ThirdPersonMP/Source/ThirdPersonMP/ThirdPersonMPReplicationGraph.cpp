@@ -0,0 +1,265 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ThirdPersonMPReplicationGraph.h"
+#include "Projectile.h"
+#include "Engine/NetConnection.h"
+#include "GameFramework/GameStateBase.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/PlayerState.h"
+#include "UObject/UObjectIterator.h"
+
+void UThirdPersonMPReplicationGraph::InitGlobalActorClassSettings()
+{
+	Super::InitGlobalActorClassSettings();
+
+	// Mirror the legacy per-actor settings (net update frequency and cull distance) of every replicated native class.
+	// Blueprint classes inherit the settings of their closest native parent.
+	for (TObjectIterator<UClass> It; It; ++It)
+	{
+		UClass* Class = *It;
+
+		const AActor* ActorCDO = Cast<AActor>(Class->GetDefaultObject(false));
+		if (ActorCDO == nullptr || !ActorCDO->GetIsReplicated())
+		{
+			continue;
+		}
+
+		// Skip SKEL and REINST classes
+		if (Class->GetName().StartsWith(TEXT("SKEL_")) || Class->GetName().StartsWith(TEXT("REINST_")))
+		{
+			continue;
+		}
+
+		FClassReplicationInfo ClassInfo;
+		ClassInfo.ReplicationPeriodFrame = GetReplicationPeriodFrameForFrequency(FMath::Max(ActorCDO->GetNetUpdateFrequency(), 1.0f));
+		ClassInfo.SetCullDistanceSquared(ActorCDO->GetNetCullDistanceSquared());
+
+		GlobalActorReplicationInfoMap.SetClassInfo(Class, ClassInfo);
+	}
+}
+
+void UThirdPersonMPReplicationGraph::InitGlobalGraphNodes()
+{
+	// Characters and props. Distant actors in a cell are replicated less often than the ones close to the viewer.
+	GridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	GridNode->CellSize = GridCellSize;
+	GridNode->SpatialBias = SpatialBias;
+	GridNode->CreateCellNodeOverride = [](UReplicationGraphNode_GridSpatialization2D* Parent)
+	{
+		UReplicationGraphNode_GridCell* Cell = Parent->CreateChildNode<UReplicationGraphNode_GridCell>();
+		Cell->CreateDynamicNodeOverride = [](UReplicationGraphNode_GridCell* CellParent) -> UReplicationGraphNode*
+		{
+			return CellParent->CreateChildNode<UReplicationGraphNode_DynamicSpatialFrequency>();
+		};
+		return Cell;
+	};
+	AddGlobalGraphNode(GridNode);
+
+	// Projectiles live for a few seconds at most, keep them out of the character grid
+	ProjectileGridNode = CreateNewNode<UReplicationGraphNode_GridSpatialization2D>();
+	ProjectileGridNode->CellSize = ProjectileGridCellSize;
+	ProjectileGridNode->SpatialBias = SpatialBias;
+	AddGlobalGraphNode(ProjectileGridNode);
+
+	// Game state, player states and other always relevant actors
+	AlwaysRelevantNode = CreateNewNode<UReplicationGraphNode_ActorList>();
+	AddGlobalGraphNode(AlwaysRelevantNode);
+}
+
+void UThirdPersonMPReplicationGraph::InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection)
+{
+	Super::InitConnectionGraphNodes(RepGraphConnection);
+
+	UThirdPersonMPReplicationGraphNode_OwnerOnly* OwnerOnlyNode = CreateNewNode<UThirdPersonMPReplicationGraphNode_OwnerOnly>();
+	AddConnectionGraphNode(OwnerOnlyNode, RepGraphConnection);
+	OwnerOnlyNodes.Add(RepGraphConnection->NetConnection, OwnerOnlyNode);
+}
+
+void UThirdPersonMPReplicationGraph::RemoveClientConnection(UNetConnection* NetConnection)
+{
+	OwnerOnlyNodes.Remove(NetConnection);
+
+	// the actors it owned go back to being unowned until the next update
+	for (TPair<AActor*, UNetConnection*>& OwnerOnlyActor : OwnerOnlyActors)
+	{
+		if (OwnerOnlyActor.Value == NetConnection)
+		{
+			OwnerOnlyActor.Value = nullptr;
+		}
+	}
+
+	Super::RemoveClientConnection(NetConnection);
+}
+
+int32 UThirdPersonMPReplicationGraph::ServerReplicateActors(float DeltaSeconds)
+{
+	// pick up owner changes once per frame, for all connections
+	for (TPair<AActor*, UNetConnection*>& OwnerOnlyActor : OwnerOnlyActors)
+	{
+		UpdateOwnerOnlyActor(OwnerOnlyActor.Key, OwnerOnlyActor.Value);
+	}
+
+	return Super::ServerReplicateActors(DeltaSeconds);
+}
+
+void UThirdPersonMPReplicationGraph::UpdateOwnerOnlyActor(AActor* Actor, UNetConnection*& Connection)
+{
+	UNetConnection* NewConnection = Actor->GetNetConnection();
+	if (NewConnection == Connection)
+	{
+		return;
+	}
+
+	RemoveOwnerOnlyActor(Actor, Connection);
+	Connection = NewConnection;
+
+	if (UThirdPersonMPReplicationGraphNode_OwnerOnly** Node = OwnerOnlyNodes.Find(NewConnection))
+	{
+		(*Node)->AddOwnedActor(Actor);
+	}
+}
+
+void UThirdPersonMPReplicationGraph::RemoveOwnerOnlyActor(AActor* Actor, UNetConnection* Connection)
+{
+	if (UThirdPersonMPReplicationGraphNode_OwnerOnly** Node = OwnerOnlyNodes.Find(Connection))
+	{
+		(*Node)->RemoveOwnedActor(Actor);
+	}
+}
+
+EThirdPersonMPRepNodeRoute UThirdPersonMPReplicationGraph::GetRoute(const AActor* Actor)
+{
+	if (Actor->IsA<APlayerController>())
+	{
+		return EThirdPersonMPRepNodeRoute::NotRouted;
+	}
+
+	if (Actor->bAlwaysRelevant || Actor->IsA<AGameStateBase>() || Actor->IsA<APlayerState>())
+	{
+		return EThirdPersonMPRepNodeRoute::RelevantAllConnections;
+	}
+
+	if (Actor->bOnlyRelevantToOwner)
+	{
+		return EThirdPersonMPRepNodeRoute::OwnerOnly;
+	}
+
+	if (Actor->IsA<AProjectile>())
+	{
+		return EThirdPersonMPRepNodeRoute::Spatialize_Projectile;
+	}
+
+	const USceneComponent* RootComponent = Actor->GetRootComponent();
+	if (RootComponent != nullptr && RootComponent->Mobility != EComponentMobility::Movable)
+	{
+		return EThirdPersonMPRepNodeRoute::Spatialize_Static;
+	}
+
+	if (Actor->NetDormancy > DORM_Awake)
+	{
+		return EThirdPersonMPRepNodeRoute::Spatialize_Dormancy;
+	}
+
+	return EThirdPersonMPRepNodeRoute::Spatialize_Dynamic;
+}
+
+void UThirdPersonMPReplicationGraph::RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo)
+{
+	const EThirdPersonMPRepNodeRoute Route = GetRoute(ActorInfo.Actor);
+	ActorRoutes.Add(ActorInfo.Actor, Route);
+
+	switch (Route)
+	{
+	case EThirdPersonMPRepNodeRoute::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyAddNetworkActor(ActorInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::OwnerOnly:
+		UpdateOwnerOnlyActor(ActorInfo.Actor, OwnerOnlyActors.Add(ActorInfo.Actor, nullptr));
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Static:
+		GridNode->AddActor_Static(ActorInfo, GlobalInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Dynamic:
+		GridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Dormancy:
+		GridNode->AddActor_Dormancy(ActorInfo, GlobalInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Projectile:
+		ProjectileGridNode->AddActor_Dynamic(ActorInfo, GlobalInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UThirdPersonMPReplicationGraph::RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo)
+{
+	EThirdPersonMPRepNodeRoute Route = EThirdPersonMPRepNodeRoute::NotRouted;
+	if (!ActorRoutes.RemoveAndCopyValue(ActorInfo.Actor, Route))
+	{
+		return;
+	}
+
+	switch (Route)
+	{
+	case EThirdPersonMPRepNodeRoute::RelevantAllConnections:
+		AlwaysRelevantNode->NotifyRemoveNetworkActor(ActorInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::OwnerOnly:
+	{
+		UNetConnection* Connection = nullptr;
+		if (OwnerOnlyActors.RemoveAndCopyValue(ActorInfo.Actor, Connection))
+		{
+			RemoveOwnerOnlyActor(ActorInfo.Actor, Connection);
+		}
+	}
+	break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Static:
+		GridNode->RemoveActor_Static(ActorInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Dynamic:
+		GridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Dormancy:
+		GridNode->RemoveActor_Dormancy(ActorInfo);
+		break;
+
+	case EThirdPersonMPRepNodeRoute::Spatialize_Projectile:
+		ProjectileGridNode->RemoveActor_Dynamic(ActorInfo);
+		break;
+
+	default:
+		break;
+	}
+}
+
+void UThirdPersonMPReplicationGraphNode_OwnerOnly::GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params)
+{
+	ReplicationActorList.Reset();
+
+	const UNetConnection* NetConnection = Params.ConnectionManager.NetConnection;
+
+	if (APlayerController* PlayerController = NetConnection->PlayerController)
+	{
+		ReplicationActorList.Add(PlayerController);
+	}
+
+	Params.OutGatheredReplicationLists.AddReplicationActorList(ReplicationActorList);
+
+	if (OwnedActors.Num() > 0)
+	{
+		Params.OutGatheredReplicationLists.AddReplicationActorList(OwnedActors);
+	}
+}
@@ -0,0 +1,116 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "ReplicationGraph.h"
+#include "ThirdPersonMPReplicationGraph.generated.h"
+
+class UReplicationGraphNode_ActorList;
+class UReplicationGraphNode_GridSpatialization2D;
+class UThirdPersonMPReplicationGraphNode_OwnerOnly;
+
+// Node an actor is routed to when it starts replicating
+enum class EThirdPersonMPRepNodeRoute : uint8
+{
+	// Not added to any node. Player controllers are replicated by their connection's owner-only node.
+	NotRouted,
+	// Replicated to every connection, e.g. the game state and player states
+	RelevantAllConnections,
+	// Only replicated to the connection that owns the actor
+	OwnerOnly,
+	// Spatialized actors that never move
+	Spatialize_Static,
+	// Spatialized actors that move, e.g. characters and physics props
+	Spatialize_Dynamic,
+	// Spatialized actors that are net dormant most of the time
+	Spatialize_Dormancy,
+	// Short-lived, fast moving actors, e.g. projectiles. They use their own grid.
+	Spatialize_Projectile
+};
+
+/**
+ * Replication graph for ThirdPersonMP.
+ * Characters and props are spatialized in a grid so each connection only considers the actors near its view, instead
+ * of every replicated actor being tested for relevancy against every connection. Spatialized actors further away from
+ * a connection replicate less often.
+ */
+UCLASS(transient, config=Engine)
+class UThirdPersonMPReplicationGraph : public UReplicationGraph
+{
+	GENERATED_BODY()
+
+public:
+	virtual void InitGlobalActorClassSettings() override;
+	virtual void InitGlobalGraphNodes() override;
+	virtual void InitConnectionGraphNodes(UNetReplicationGraphConnection* RepGraphConnection) override;
+	virtual void RouteAddNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo, FGlobalActorReplicationInfo& GlobalInfo) override;
+	virtual void RouteRemoveNetworkActorToNodes(const FNewReplicatedActorInfo& ActorInfo) override;
+	virtual void RemoveClientConnection(UNetConnection* NetConnection) override;
+	virtual int32 ServerReplicateActors(float DeltaSeconds) override;
+
+protected:
+	// Size of a cell of the character and prop grid in cm
+	UPROPERTY(Config)
+	float GridCellSize = 10000.0f;
+
+	// Size of a cell of the projectile grid in cm
+	UPROPERTY(Config)
+	float ProjectileGridCellSize = 5000.0f;
+
+	// Lower bound of the world in cm. Actors beyond it are clamped into the first cell.
+	UPROPERTY(Config)
+	FVector2D SpatialBias = FVector2D(-150000.0f, -200000.0f);
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> GridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_GridSpatialization2D> ProjectileGridNode;
+
+	UPROPERTY()
+	TObjectPtr<UReplicationGraphNode_ActorList> AlwaysRelevantNode;
+
+private:
+	static EThirdPersonMPRepNodeRoute GetRoute(const AActor* Actor);
+
+	// Hands an owner-only actor to the owner-only node of the connection that owns it now
+	void UpdateOwnerOnlyActor(AActor* Actor, UNetConnection*& Connection);
+
+	// Removes an owner-only actor from the owner-only node of the connection it was handed to
+	void RemoveOwnerOnlyActor(AActor* Actor, UNetConnection* Connection);
+
+	// Actors only relevant to their owning connection, and the connection whose owner-only node replicates each one.
+	// Owners can change, so this is checked once per frame, rather than each connection scanning every owner-only actor.
+	TMap<AActor*, UNetConnection*> OwnerOnlyActors;
+
+	// Owner-only node of each client connection
+	TMap<UNetConnection*, UThirdPersonMPReplicationGraphNode_OwnerOnly*> OwnerOnlyNodes;
+
+	// Route each actor was added with, so it is removed from the same node even if its flags changed since
+	TMap<TObjectKey<AActor>, EThirdPersonMPRepNodeRoute> ActorRoutes;
+};
+
+/**
+ * Per-connection node replicating the connection's player controller and the actors only relevant to that connection
+ */
+UCLASS()
+class UThirdPersonMPReplicationGraphNode_OwnerOnly : public UReplicationGraphNode
+{
+	GENERATED_BODY()
+
+public:
+	virtual void NotifyAddNetworkActor(const FNewReplicatedActorInfo& ActorInfo) override { }
+	virtual bool NotifyRemoveNetworkActor(const FNewReplicatedActorInfo& ActorInfo, bool bWarnIfNotFound = true) override { return false; }
+	virtual void NotifyResetAllNetworkActors() override { }
+	virtual void GatherActorListsForConnection(const FConnectionGatherActorListParameters& Params) override;
+
+	void AddOwnedActor(AActor* Actor) { OwnedActors.Add(Actor); }
+	void RemoveOwnedActor(AActor* Actor) { OwnedActors.RemoveFast(Actor); }
+
+private:
+	FActorRepListRefView ReplicationActorList;
+
+	// Owner-only actors owned by this node's connection, kept up to date by the graph
+	FActorRepListRefView OwnedActors;
+};
@@ -3,11 +3,12 @@
 
 #include "CombatAIController.h"
 #include "Components/StateTreeAIComponent.h"
+#include "ThinkLODStateTreeAIComponent.h"
 
 ACombatAIController::ACombatAIController()
 {
-	// create the StateTree AI Component
-	StateTreeAI = CreateDefaultSubobject<UStateTreeAIComponent>(TEXT("StateTreeAI"));
+	// create the StateTree AI Component. Its think rate is scheduled by distance to the players
+	StateTreeAI = CreateDefaultSubobject<UThinkLODStateTreeAIComponent>(TEXT("StateTreeAI"));
 	check(StateTreeAI);
 
 	// ensure we start the StateTree when we possess the pawn
@@ -5,12 +5,18 @@
 #include "Components/CapsuleComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "CombatAIController.h"
-#include "Components/WidgetComponent.h"
+#include "BrainComponent.h"
 #include "Engine/DamageEvents.h"
-#include "CombatLifeBar.h"
+#include "CombatLifeBarSubsystem.h"
 #include "TimerManager.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Animation/AnimInstance.h"
+#include "HealthComponent.h"
+#include "ClientOnlyComponents.h"
+#include "CombatAttackTimelineComponent.h"
+#include "CombatTraceSubsystem.h"
+#include "CombatRagdollSubsystem.h"
+#include "ThirdPersonMP.h"
 
 ACombatEnemy::ACombatEnemy()
 {
@@ -28,9 +34,12 @@ ACombatEnemy::ACombatEnemy()
 	// ignore the controller's yaw rotation
 	bUseControllerRotationYaw = false;
 
-	// create the life bar
-	LifeBar = CreateDefaultSubobject<UWidgetComponent>(TEXT("LifeBar"));
-	LifeBar->SetupAttachment(RootComponent);
+	// create the health component
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComponent"));
+	HealthComponent->MaxHealth = 3.0f;
+
+	// create the attack timeline, used to play attacks without animation on dedicated servers
+	AttackTimeline = CreateDefaultSubobject<UCombatAttackTimelineComponent>(TEXT("AttackTimeline"));
 
 	// set the collision capsule size
 	GetCapsuleComponent()->SetCapsuleSize(35.0f, 90.0f);
@@ -39,7 +48,7 @@ ACombatEnemy::ACombatEnemy()
 	GetCharacterMovement()->bUseControllerDesiredRotation = true;
 
 	// reset HP to maximum
-	CurrentHP = MaxHP;
+	CurrentHP = HealthComponent->MaxHealth;
 }
 
 void ACombatEnemy::DoAIComboAttack()
@@ -60,17 +69,7 @@ void ACombatEnemy::DoAIComboAttack()
 	CurrentComboAttack = 0;
 
 	// play the attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		const float MontageLength = AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-
-		// subscribe to montage completed and interrupted events
-		if (MontageLength > 0.0f)
-		{
-			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
-		}
-	}
+	PlayAttackMontage(ComboAttackMontage);
 }
 
 void ACombatEnemy::DoAIChargedAttack()
@@ -91,17 +90,59 @@ void ACombatEnemy::DoAIChargedAttack()
 	CurrentChargeLoop = 0;
 
 	// play the attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	PlayAttackMontage(ChargedAttackMontage);
+}
+
+void ACombatEnemy::PlayAttackMontage(UAnimMontage* Montage)
+{
+	// start a new swing so targets can be hit again
+	++AttackSwingId;
+
+	// dedicated servers play the attack from its baked timing
+	if (AttackTimeline->IsUsingBakedTiming())
 	{
-		const float MontageLength = AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+		if (AttackTimeline->Play(Montage, OnAttackMontageEnded))
+		{
+			return;
+		}
+	}
+	else if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		// play the attack montage
+		const float MontageLength = AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
 
 		// subscribe to montage completed and interrupted events
 		if (MontageLength > 0.0f)
 		{
 			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
+			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, Montage);
+			return;
 		}
 	}
+
+	// the attack couldn't start, so no end event will lower the attacking flag
+	UE_LOG(LogThirdPersonMP, Warning, TEXT("%s couldn't play attack montage %s"), *GetName(), *GetNameSafe(Montage));
+
+	// end the attack so the StateTree doesn't wait on it forever
+	AttackMontageEnded(Montage, true);
+}
+
+void ACombatEnemy::JumpToAttackSection(FName SectionName, UAnimMontage* Montage)
+{
+	// every section is a new swing
+	++AttackSwingId;
+
+	// dedicated servers play the attack from its baked timing
+	if (AttackTimeline->IsUsingBakedTiming())
+	{
+		AttackTimeline->JumpToSection(SectionName, Montage);
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+	}
 }
 
 void ACombatEnemy::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
@@ -115,45 +156,54 @@ void ACombatEnemy::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
 
 void ACombatEnemy::DoAttackTrace(FName DamageSourceBone)
 {
-	// sweep for objects in front of the character to be hit by the attack
-	TArray<FHitResult> OutHits;
+	// start at the provided socket location
+	DoAttackTraceFromLocation(GetMesh()->GetSocketLocation(DamageSourceBone));
+}
 
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
-	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+void ACombatEnemy::DoAttackTraceFromLocation(const FVector& TraceStart)
+{
+	UCombatTraceSubsystem* CombatTrace = GetWorld()->GetSubsystem<UCombatTraceSubsystem>();
 
-	// enemies only affect Pawn collision objects; they don't knock back boxes
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	if (!CombatTrace)
+	{
+		return;
+	}
 
-	// use a sphere shape for the sweep
-	FCollisionShape CollisionShape;
-	CollisionShape.SetSphere(MeleeTraceRadius);
+	// sweep a sphere forward from the trace start
+	FCombatSweepRequest Request;
+	Request.Attacker = this;
+	Request.SwingId = AttackSwingId;
+	Request.Start = TraceStart;
+	Request.End = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+	Request.Radius = MeleeTraceRadius;
 
-	// ignore self
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
+	// enemies only affect Pawn collision objects; they don't knock back boxes
+	Request.ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
 
-	if (GetWorld()->SweepMultiByObjectType(OutHits, TraceStart, TraceEnd, FQuat::Identity, ObjectParams, CollisionShape, QueryParams))
+	// the hits are resolved once the batched sweep comes back
+	Request.OnResolved.BindUObject(this, &ACombatEnemy::ResolveAttackHits);
+	CombatTrace->QueueSweep(MoveTemp(Request));
+}
+
+void ACombatEnemy::ResolveAttackHits(const TArray<FHitResult>& Hits)
+{
+	// iterate over each object hit
+	for (const FHitResult& CurrentHit : Hits)
 	{
-		// iterate over each object hit
-		for (const FHitResult& CurrentHit : OutHits)
+		/** does the actor have the player tag? */
+		if (CurrentHit.GetActor()->ActorHasTag(FName("Player")))
 		{
-			/** does the actor have the player tag? */
-			if (CurrentHit.GetActor()->ActorHasTag(FName("Player")))
-			{
-				// check if the actor is damageable
-				ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
+			// check if the actor is damageable
+			ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
 
-				if (Damageable)
-				{
-					// knock upwards and away from the impact normal
-					const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
+			if (Damageable)
+			{
+				// knock upwards and away from the impact normal
+				const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
 
-					// pass the damage event to the actor
-					Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
+				// pass the damage event to the actor
+				Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
 
-				}
 			}
 		}
 	}
@@ -168,10 +218,7 @@ void ACombatEnemy::CheckCombo()
 	if (CurrentComboAttack < TargetComboCount)
 	{
 		// jump to the next attack section
-		if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-		{
-			AnimInstance->Montage_JumpToSection(ComboSectionNames[CurrentComboAttack], ComboAttackMontage);
-		}
+		JumpToAttackSection(ComboSectionNames[CurrentComboAttack], ComboAttackMontage);
 	}
 }
 
@@ -181,10 +228,7 @@ void ACombatEnemy::CheckChargedAttack()
 	++CurrentChargeLoop;
 
 	// jump to either the loop or attack section of the montage depending on whether we hit the loop target
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		AnimInstance->Montage_JumpToSection(CurrentChargeLoop >= TargetChargeLoops ? ChargeAttackSection : ChargeLoopSection, ChargedAttackMontage);
-	}
+	JumpToAttackSection(CurrentChargeLoop >= TargetChargeLoops ? ChargeAttackSection : ChargeLoopSection, ChargedAttackMontage);
 }
 
 void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
@@ -214,6 +258,12 @@ void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector
 			AnimInstance->Montage_Stop(0.1f, ChargedAttackMontage);
 		}
 
+		// attacks played from baked timing don't go through the AnimInstance, interrupt those too
+		if (AttackTimeline->IsUsingBakedTiming())
+		{
+			AttackTimeline->Stop();
+		}
+
 		// pass control to BP to play effects, etc.
 		ReceivedDamage(ActualDamage, DamageLocation, DamageImpulse.GetSafeNormal());
 	}
@@ -222,7 +272,10 @@ void ACombatEnemy::ApplyDamage(float Damage, AActor* DamageCauser, const FVector
 void ACombatEnemy::HandleDeath()
 {
 	// hide the life bar
-	LifeBar->SetHiddenInGame(true);
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifeBarVisible(this, false);
+	}
 
 	// disable the collision capsule to avoid being hit again while dead
 	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
@@ -230,8 +283,21 @@ void ACombatEnemy::HandleDeath()
 	// disable character movement
 	GetCharacterMovement()->DisableMovement();
 
-	// enable full ragdoll physics
-	GetMesh()->SetSimulatePhysics(true);
+	// the death animation or ragdoll ends an animated attack, a baked one has to be stopped
+	if (AttackTimeline->IsUsingBakedTiming())
+	{
+		AttackTimeline->Stop();
+	}
+
+	// ragdoll if the budget allows, otherwise play the death animation
+	if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+	{
+		Ragdolls->StartDeathRagdoll(this, DeathMontage);
+	}
+	else
+	{
+		GetMesh()->SetSimulatePhysics(true);
+	}
 
 	// call the died delegate to notify any subscribers
 	OnEnemyDied.Broadcast();
@@ -247,35 +313,130 @@ void ACombatEnemy::ApplyHealing(float Healing, AActor* Healer)
 
 void ACombatEnemy::RemoveFromLevel()
 {
+	// are we pooled?
+	if (OnEnemyRemoved.IsBound())
+	{
+		// go back to the pool instead of being destroyed
+		DeactivateForPool();
+		OnEnemyRemoved.Execute(this);
+		return;
+	}
+
 	// destroy this actor
 	Destroy();
 }
 
+void ACombatEnemy::DeactivateForPool()
+{
+	// clear the death timer
+	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// stop the StateTree
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
+		{
+			BrainComponent->StopLogic(TEXT("Pooled"));
+		}
+	}
+
+	// interrupt any attack in progress
+	AttackTimeline->Stop();
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->StopAllMontages(0.0f);
+	}
+
+	bIsAttacking = false;
+
+	// free our ragdoll slot
+	if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+	{
+		Ragdolls->Release(this);
+	}
+
+	// stop the ragdoll and put the mesh back on the capsule
+	GetMesh()->SetSimulatePhysics(false);
+	GetMesh()->SetPhysicsBlendWeight(0.0f);
+	GetMesh()->AttachToComponent(GetCapsuleComponent(), FAttachmentTransformRules::SnapToTargetNotIncludingScale);
+	GetMesh()->SetRelativeLocationAndRotation(GetBaseTranslationOffset(), GetBaseRotationOffset());
+
+	// disable collision and movement
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	GetCharacterMovement()->StopMovementImmediately();
+	GetCharacterMovement()->DisableMovement();
+
+	// hide the enemy and stop ticking
+	SetActorHiddenInGame(true);
+	SetActorTickEnabled(false);
+}
+
+void ACombatEnemy::ActivateFromPool(const FTransform& SpawnTransform)
+{
+	// move to the spawn point
+	SetActorTransform(SpawnTransform, false, nullptr, ETeleportType::ResetPhysics);
+
+	// show the enemy and resume ticking
+	SetActorHiddenInGame(false);
+	SetActorTickEnabled(true);
+
+	// restore collision and movement
+	GetCapsuleComponent()->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	GetCharacterMovement()->SetDefaultMovementMode();
+
+	// reset HP to maximum
+	HealthComponent->ResetHealth();
+	CurrentHP = HealthComponent->GetHealth();
+
+	// show and fill the life bar
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifeBarVisible(this, true);
+		LifeBars->SetLifePercentage(this, 1.0f);
+	}
+
+	// restart the StateTree now that the HP are topped
+	if (AAIController* AIController = Cast<AAIController>(GetController()))
+	{
+		if (UBrainComponent* BrainComponent = AIController->GetBrainComponent())
+		{
+			BrainComponent->StartLogic();
+		}
+	}
+}
+
 float ACombatEnemy::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
 	// only process damage if the character is still alive
-	if (CurrentHP <= 0.0f)
+	if (HealthComponent->IsDead())
 	{
 		return 0.0f;
 	}
 
-	// reduce the current HP
-	CurrentHP -= Damage;
+	// reduce the current HP. The life bar is updated once all the damage of this frame is applied
+	HealthComponent->ApplyDamage(Damage);
+	CurrentHP = HealthComponent->GetHealth();
 
 	// have we run out of HP?
-	if (CurrentHP <= 0.0f)
+	if (HealthComponent->IsDead())
 	{
 		// die
 		HandleDeath();
 	}
 	else
 	{
-		// update the life bar
-		LifeBarWidget->SetLifePercentage(CurrentHP / MaxHP);
-
-		// enable partial ragdoll physics, but keep the pelvis vertical
-		GetMesh()->SetPhysicsBlendWeight(0.5f);
-		GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		// enable partial ragdoll physics if the budget allows
+		if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+		{
+			Ragdolls->StartHitReact(this, PelvisBoneName);
+		}
+		else
+		{
+			// keep the pelvis vertical
+			GetMesh()->SetPhysicsBlendWeight(0.5f);
+			GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		}
 	}
 
 	// return the received damage amount
@@ -290,27 +451,70 @@ void ACombatEnemy::Landed(const FHitResult& Hit)
 	if (CurrentHP >= 0.0f)
 	{
 		// disable ragdoll physics
-		GetMesh()->SetPhysicsBlendWeight(0.0f);
+		if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+		{
+			Ragdolls->EndHitReact(this);
+		}
+		else
+		{
+			GetMesh()->SetPhysicsBlendWeight(0.0f);
+		}
 	}
 
 	// call the landed Delegate for StateTree
 	OnEnemyLanded.ExecuteIfBound();
 }
 
+void ACombatEnemy::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// move the max HP saved before health moved to the health component
+	if (MaxHP_DEPRECATED >= 0.0f)
+	{
+		HealthComponent->MaxHealth = MaxHP_DEPRECATED;
+		MaxHP_DEPRECATED = -1.0f;
+	}
+#endif
+}
+
+void ACombatEnemy::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	ClientOnlyComponents::ReportFootprint(this);
+}
+
 void ACombatEnemy::BeginPlay()
 {
 	// reset HP to maximum
-	CurrentHP = MaxHP;
+	HealthComponent->ResetHealth();
+	CurrentHP = HealthComponent->GetHealth();
 
 	// we top the HP before BeginPlay so StateTree picks it up at the right value
 	Super::BeginPlay();
 
-	// get the life bar widget from the widget comp
-	LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
-	check(LifeBarWidget);
+	// add our life bar to the life bar layer
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->RegisterLifeBar(this, LifeBarColor, LifeBarOffset);
+	}
 
-	// fill the life bar
-	LifeBarWidget->SetLifePercentage(1.0f);
+	// update the life bar whenever the HP change
+	HealthComponent->OnHealthChanged.AddDynamic(this, &ACombatEnemy::OnHealthChanged);
+}
+
+void ACombatEnemy::OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth)
+{
+	// keep the StateTree copy up to date on clients
+	CurrentHP = NewHealth;
+
+	// update the life bar
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifePercentage(this, HealthComponent->GetHealthPercent());
+	}
 }
 
 void ACombatEnemy::EndPlay(EEndPlayReason::Type EndPlayReason)
@@ -319,4 +523,10 @@ void ACombatEnemy::EndPlay(EEndPlayReason::Type EndPlayReason)
 
 	// clear the death timer
 	GetWorld()->GetTimerManager().ClearTimer(DeathTimer);
+
+	// remove our life bar
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->UnregisterLifeBar(this);
+	}
 }
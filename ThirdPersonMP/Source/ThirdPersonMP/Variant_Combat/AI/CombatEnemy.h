@@ -10,9 +10,9 @@
 #include "Engine/TimerHandle.h"
 #include "CombatEnemy.generated.h"
 
-class UWidgetComponent;
-class UCombatLifeBar;
 class UAnimMontage;
+class UHealthComponent;
+class UCombatAttackTimelineComponent;
 
 /** Completed attack animation delegate for StateTree */
 DECLARE_DELEGATE(FOnEnemyAttackCompleted);
@@ -23,6 +23,9 @@ DECLARE_DELEGATE(FOnEnemyLanded);
 /** Enemy died delegate */
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FOnEnemyDied);
 
+/** Enemy removed from the level delegate, for pooling */
+DECLARE_DELEGATE_OneParam(FOnEnemyRemoved, ACombatEnemy* /*Enemy*/);
+
 /**
  *  An AI-controlled character with combat capabilities.
  *  Its bundled AI Controller runs logic through StateTree
@@ -32,40 +35,51 @@ class ACombatEnemy : public ACharacter, public ICombatAttacker, public ICombatDa
 {
 	GENERATED_BODY()
 
-	/** Life bar widget component */
+	/** Health component, holds the character's HP */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UHealthComponent* HealthComponent;
+
+	/** Plays attacks from baked montage timing on dedicated servers */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
-	UWidgetComponent* LifeBar;
+	UCombatAttackTimelineComponent* AttackTimeline;
 
 public:
 	
 	/** Constructor */
 	ACombatEnemy();
 
-protected:
-
-	/** Max amount of HP the character will have on respawn */
-	UPROPERTY(EditAnywhere, Category="Damage")
-	float MaxHP = 3.0f;
-
 public:
 
-	/** Current amount of HP the character has */
+	/** Current amount of HP the character has. Mirrors the health component for StateTree bindings */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Damage", meta = (ClampMin = 0, ClampMax = 100))
 	float CurrentHP = 0.0f;
 
 protected:
 
+#if WITH_EDITORONLY_DATA
+	/** Max HP saved before it moved to the health component, copied to it on load. Negative when unset */
+	UPROPERTY()
+	float MaxHP_DEPRECATED = -1.0f;
+#endif
+
 	/** Name of the pelvis bone, for damage ragdoll physics */
 	UPROPERTY(EditAnywhere, Category="Damage")
 	FName PelvisBoneName;
 
-	/** Pointer to the life bar widget */
+	/** Life bar fill color */
+	UPROPERTY(EditAnywhere, Category="Damage")
+	FLinearColor LifeBarColor = FLinearColor(0.8f, 0.05f, 0.05f);
+
+	/** Offset from the character's location to its life bar */
 	UPROPERTY(EditAnywhere, Category="Damage")
-	UCombatLifeBar* LifeBarWidget;
+	FVector LifeBarOffset = FVector(0.0f, 0.0f, 120.0f);
 
 	/** If true, the character is currently playing an attack animation */
 	bool bIsAttacking = false;
 
+	/** Identifies the current attack swing. Each target is only hit once per swing */
+	uint32 AttackSwingId = 0;
+
 	/** Distance ahead of the character that melee attack sphere collision traces will extend */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace", meta = (ClampMin = 0, ClampMax = 500, Units = "cm"))
 	float MeleeTraceDistance = 75.0f;
@@ -126,6 +140,10 @@ protected:
 	/** Number of charge animation loop currently playing */
 	int32 CurrentChargeLoop = 0;
 
+	/** Death animation played when the ragdoll budget is full. Should not auto blend out */
+	UPROPERTY(EditAnywhere, Category="Death")
+	UAnimMontage* DeathMontage;
+
 	/** Time to wait before removing this character from the level after it dies */
 	UPROPERTY(EditAnywhere, Category="Death")
 	float DeathRemovalTime = 5.0f;
@@ -147,6 +165,9 @@ public:
 	UPROPERTY(BlueprintAssignable, Category="Events")
 	FOnEnemyDied OnEnemyDied;
 
+	/** Enemy removed delegate. If bound, the enemy is deactivated and handed to it instead of being destroyed */
+	FOnEnemyRemoved OnEnemyRemoved;
+
 public:
 
 	/** Performs an AI-initiated combo attack. Number of hits will be decided by this character */
@@ -155,9 +176,24 @@ public:
 	/** Performs an AI-initiated charged attack. Charge time will be decided by this character */
 	void DoAIChargedAttack();
 
+	/** Plays an attack montage, or its baked timing on dedicated servers */
+	void PlayAttackMontage(UAnimMontage* Montage);
+
+	/** Jumps to a section of the attack montage being played */
+	void JumpToAttackSection(FName SectionName, UAnimMontage* Montage);
+
+	/** Applies damage to the players hit by an attack sweep */
+	void ResolveAttackHits(const TArray<FHitResult>& Hits);
+
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Hides the enemy and stops its AI, physics and collision so it can wait in a pool */
+	void DeactivateForPool();
+
+	/** Brings a pooled enemy back at the given transform with full HP and restarts its AI */
+	void ActivateFromPool(const FTransform& SpawnTransform);
+
 public:
 
 	// ~begin ICombatAttacker interface
@@ -165,6 +201,9 @@ public:
 	/** Performs an attack's collision check */
 	virtual void DoAttackTrace(FName DamageSourceBone) override;
 
+	/** Performs an attack's collision check from the given location. Hits are resolved when the batched sweep completes */
+	virtual void DoAttackTraceFromLocation(const FVector& TraceStart) override;
+
 	/** Performs a combo attack's check to continue the string */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckCombo() override;
@@ -207,8 +246,18 @@ protected:
 	UFUNCTION(BlueprintImplementableEvent, Category="Combat")
 	void ReceivedDamage(float Damage, const FVector& ImpactPoint, const FVector& DamageDirection);
 
+	/** Updates the life bar when the HP changed, at most once per frame */
+	UFUNCTION()
+	void OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth);
+
 protected:
 
+	/** Migrates health data saved before the health component */
+	virtual void PostLoad() override;
+
+	/** Reports the character's component footprint */
+	virtual void PostInitializeComponents() override;
+
 	/** Gameplay initialization */
 	virtual void BeginPlay() override;
 
@@ -7,6 +7,7 @@
 #include "Components/ArrowComponent.h"
 #include "TimerManager.h"
 #include "CombatEnemy.h"
+#include "ClientOnlyComponents.h"
 
 ACombatEnemySpawner::ACombatEnemySpawner()
 {
@@ -30,12 +31,25 @@ ACombatEnemySpawner::ACombatEnemySpawner()
 void ACombatEnemySpawner::BeginPlay()
 {
 	Super::BeginPlay();
+
+	// construct the pooled enemies now rather than mid-fight
+	if (IsValid(EnemyClass))
+	{
+		const int32 PrewarmCount = FMath::Min(PoolSize, SpawnCount);
+		for (int32 i = 0; i < PrewarmCount; ++i)
+		{
+			if (ACombatEnemy* Enemy = CreatePooledEnemy())
+			{
+				PooledEnemies.Add(Enemy);
+			}
+		}
+	}
 	
 	// should we spawn an enemy right away?
 	if (bShouldSpawnEnemiesImmediately)
 	{
 		// schedule the first enemy spawn
-		GetWorld()->GetTimerManager().SetTimer(SpawnTimer, this, &ACombatEnemySpawner::SpawnEnemy, InitialSpawnDelay);
+		GetWorld()->GetTimerManager().SetTimer(SpawnTimer, this, &ACombatEnemySpawner::QueueSpawnEnemy, InitialSpawnDelay);
 	}
 
 }
@@ -48,24 +62,89 @@ void ACombatEnemySpawner::EndPlay(EEndPlayReason::Type EndPlayReason)
 	GetWorld()->GetTimerManager().ClearTimer(SpawnTimer);
 }
 
+void ACombatEnemySpawner::QueueSpawnEnemy()
+{
+	UCombatSpawnQueueSubsystem* SpawnQueue = GetWorld()->GetSubsystem<UCombatSpawnQueueSubsystem>();
+
+	// no queue in this world, spawn right away
+	if (!SpawnQueue)
+	{
+		SpawnEnemy();
+		return;
+	}
+
+	// spawn when the queue gets to us
+	FCombatSpawnRequest Request;
+	Request.Execute.BindUObject(this, &ACombatEnemySpawner::SpawnEnemy);
+	Request.Priority = SpawnPriority;
+	SpawnQueue->Enqueue(MoveTemp(Request));
+}
+
 void ACombatEnemySpawner::SpawnEnemy()
 {
 	// ensure the enemy class is valid
-	if (IsValid(EnemyClass))
+	if (!IsValid(EnemyClass))
 	{
-		// spawn the enemy at the reference capsule's transform
-		FActorSpawnParameters SpawnParams;
-		SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+		return;
+	}
 
-		ACombatEnemy* SpawnedEnemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, SpawnCapsule->GetComponentTransform(), SpawnParams);
+	// take an enemy from the pool, or construct one if they're all still in use
+	ACombatEnemy* SpawnedEnemy = nullptr;
 
-		// was the enemy successfully created?
-		if (SpawnedEnemy)
+	while (!SpawnedEnemy && PooledEnemies.Num() > 0)
+	{
+		SpawnedEnemy = PooledEnemies.Pop(EAllowShrinking::No);
+
+		// skip enemies destroyed while pooled
+		if (!IsValid(SpawnedEnemy))
 		{
-			// subscribe to the death delegate
-			SpawnedEnemy->OnEnemyDied.AddDynamic(this, &ACombatEnemySpawner::OnEnemyDied);
+			SpawnedEnemy = nullptr;
 		}
 	}
+
+	if (!SpawnedEnemy)
+	{
+		SpawnedEnemy = CreatePooledEnemy();
+	}
+
+	// was the enemy successfully created?
+	if (SpawnedEnemy)
+	{
+		// bring the enemy in at the reference capsule's transform
+		SpawnedEnemy->ActivateFromPool(SpawnCapsule->GetComponentTransform());
+	}
+}
+
+ACombatEnemy* ACombatEnemySpawner::CreatePooledEnemy()
+{
+	// spawn the enemy at the reference capsule's transform
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	ACombatEnemy* Enemy = nullptr;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CharacterSpawn);
+		Enemy = GetWorld()->SpawnActor<ACombatEnemy>(EnemyClass, SpawnCapsule->GetComponentTransform(), SpawnParams);
+	}
+
+	if (!Enemy)
+	{
+		return nullptr;
+	}
+
+	// subscribe to the death and removal delegates. They stay bound while the enemy is reused
+	Enemy->OnEnemyDied.AddDynamic(this, &ACombatEnemySpawner::OnEnemyDied);
+	Enemy->OnEnemyRemoved.BindUObject(this, &ACombatEnemySpawner::ReturnToPool);
+
+	// wait in the pool until spawned
+	Enemy->DeactivateForPool();
+
+	return Enemy;
+}
+
+void ACombatEnemySpawner::ReturnToPool(ACombatEnemy* Enemy)
+{
+	PooledEnemies.Add(Enemy);
 }
 
 void ACombatEnemySpawner::OnEnemyDied()
@@ -82,7 +161,7 @@ void ACombatEnemySpawner::OnEnemyDied()
 	}
 
 	// schedule the next enemy spawn
-	GetWorld()->GetTimerManager().SetTimer(SpawnTimer, this, &ACombatEnemySpawner::SpawnEnemy, RespawnDelay);
+	GetWorld()->GetTimerManager().SetTimer(SpawnTimer, this, &ACombatEnemySpawner::QueueSpawnEnemy, RespawnDelay);
 }
 
 void ACombatEnemySpawner::SpawnerDepleted()
@@ -116,7 +195,7 @@ void ACombatEnemySpawner::ActivateInteraction(AActor* ActivationInstigator)
 	bHasBeenActivated = true;
 
 	// spawn the first enemy
-	SpawnEnemy();
+	QueueSpawnEnemy();
 }
 
 void ACombatEnemySpawner::DeactivateInteraction(AActor* ActivationInstigator)
@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
 #include "CombatActivatable.h"
+#include "CombatSpawnQueueSubsystem.h"
 #include "CombatEnemySpawner.generated.h"
 
 class UCapsuleComponent;
@@ -50,6 +51,18 @@ protected:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner", meta = (ClampMin = 0, ClampMax = 10))
 	float RespawnDelay = 5.0f;
 
+	/** Priority of this spawner's spawns in the spawn queue */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner")
+	ECombatSpawnPriority SpawnPriority = ECombatSpawnPriority::Normal;
+
+	/** Number of enemies constructed on level load and reused. Covers a new enemy spawning while the last one is still ragdolling */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Enemy Spawner", meta = (ClampMin = 1, ClampMax = 10))
+	int32 PoolSize = 2;
+
+	/** Inactive enemies ready to be spawned */
+	UPROPERTY(Transient)
+	TArray<ACombatEnemy*> PooledEnemies;
+
 	/** Time to wait after this spawner is depleted before activating the actor list */
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category="Activation", meta = (ClampMin = 0, ClampMax = 10))
 	float ActivationDelay = 1.0f;
@@ -79,9 +92,18 @@ public:
 
 protected:
 
-	/** Spawn an enemy and subscribe to its death event */
+	/** Queues an enemy spawn in the spawn queue */
+	void QueueSpawnEnemy();
+
+	/** Spawn an enemy from the pool */
 	void SpawnEnemy();
 
+	/** Constructs an inactive enemy for the pool and subscribes to its death and removal events */
+	ACombatEnemy* CreatePooledEnemy();
+
+	/** Called when a dead enemy is removed from the level */
+	void ReturnToPool(ACombatEnemy* Enemy);
+
 	/** Called when the spawned enemy has died */
 	UFUNCTION()
 	void OnEnemyDied();
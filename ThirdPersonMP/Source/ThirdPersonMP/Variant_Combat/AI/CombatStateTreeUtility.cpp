@@ -8,7 +8,7 @@
 #include "GameFramework/CharacterMovementComponent.h"
 #include "AIController.h"
 #include "CombatEnemy.h"
-#include "Kismet/GameplayStatics.h"
+#include "PlayerTargetSubsystem.h"
 #include "StateTreeAsyncExecutionContext.h"
 
 bool FStateTreeCharacterGroundedCondition::TestCondition(FStateTreeExecutionContext& Context) const
@@ -266,8 +266,11 @@ EStateTreeRunStatus FStateTreeGetPlayerInfoTask::Tick(FStateTreeExecutionContext
 	// get the instance data
 	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-	// get the character possessed by the first local player
-	InstanceData.TargetPlayerCharacter = Cast<ACharacter>(UGameplayStatics::GetPlayerPawn(InstanceData.Character, 0));
+	// get the character possessed by the nearest player
+	if (UPlayerTargetSubsystem* PlayerTargets = InstanceData.Character->GetWorld()->GetSubsystem<UPlayerTargetSubsystem>())
+	{
+		InstanceData.TargetPlayerCharacter = Cast<ACharacter>(PlayerTargets->FindNearestPlayer(InstanceData.Character->GetActorLocation()));
+	}
 
 	// do we have a valid target?
 	if (InstanceData.TargetPlayerCharacter)
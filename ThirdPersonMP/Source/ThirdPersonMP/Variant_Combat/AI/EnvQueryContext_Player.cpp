@@ -2,16 +2,37 @@
 
 
 #include "EnvQueryContext_Player.h"
-#include "Kismet/GameplayStatics.h"
+#include "PlayerTargetSubsystem.h"
+#include "GameFramework/Controller.h"
+#include "Engine/World.h"
 #include "EnvironmentQuery/EnvQueryTypes.h"
 #include "EnvironmentQuery/Items/EnvQueryItemType_Actor.h"
 #include "GameFramework/Pawn.h"
 
 void UEnvQueryContext_Player::ProvideContext(FEnvQueryInstance& QueryInstance, FEnvQueryContextData& ContextData) const
 {
-	// get the player pawn for the first local player
-	AActor* PlayerPawn = UGameplayStatics::GetPlayerPawn(QueryInstance.Owner.Get(), 0);
-	check(PlayerPawn);
+	// find the actor running the query. Controllers query from their pawn's location
+	const AActor* Querier = Cast<AActor>(QueryInstance.Owner.Get());
+
+	if (const AController* Controller = Cast<AController>(Querier))
+	{
+		Querier = Controller->GetPawn();
+	}
+
+	if (!Querier)
+	{
+		return;
+	}
+
+	// get the player pawn nearest to the querier
+	UPlayerTargetSubsystem* PlayerTargets = Querier->GetWorld()->GetSubsystem<UPlayerTargetSubsystem>();
+	AActor* PlayerPawn = PlayerTargets ? PlayerTargets->FindNearestPlayer(Querier->GetActorLocation()) : nullptr;
+
+	// no players to query around
+	if (!PlayerPawn)
+	{
+		return;
+	}
 
 	// add the actor data to the context
 	UEnvQueryItemType_Actor::SetContextHelper(ContextData, PlayerPawn);
@@ -0,0 +1,196 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAttackTimelineComponent.h"
+#include "CombatAttackTiming.h"
+#include "CombatAttacker.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<bool> CVarCombatBakedAttackTiming(
+	TEXT("Combat.BakedAttackTiming"),
+	true,
+	TEXT("On dedicated servers, play melee attacks from timing baked from the attack montages and skip skeletal animation."),
+	ECVF_Default);
+
+UCombatAttackTimelineComponent::UCombatAttackTimelineComponent()
+{
+	// only tick while a montage is playing
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+}
+
+void UCombatAttackTimelineComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// nobody sees the animation on a dedicated server, so only its timing matters
+	bUseBakedTiming = GetNetMode() == NM_DedicatedServer && CVarCombatBakedAttackTiming.GetValueOnGameThread();
+
+	if (bUseBakedTiming)
+	{
+		if (ACharacter* Character = Cast<ACharacter>(GetOwner()))
+		{
+			// pose is never evaluated since nothing is ever rendered
+			Character->GetMesh()->VisibilityBasedAnimTickOption = EVisibilityBasedAnimTickOption::OnlyTickPoseWhenRendered;
+		}
+	}
+}
+
+bool UCombatAttackTimelineComponent::Play(UAnimMontage* Montage, const FOnMontageEnded& InOnMontageEnded)
+{
+	const ACharacter* Character = Cast<ACharacter>(GetOwner());
+	UCombatAttackTimingSubsystem* TimingSubsystem = GetWorld()->GetSubsystem<UCombatAttackTimingSubsystem>();
+
+	if (!Character || !TimingSubsystem)
+	{
+		return false;
+	}
+
+	// get the baked timing for this montage and mesh
+	const FCombatAttackTimingTable* NewTimingTable = TimingSubsystem->GetTimingTable(Montage, Character->GetMesh()->GetSkeletalMeshAsset());
+
+	if (!NewTimingTable)
+	{
+		return false;
+	}
+
+	// the previous montage, if any, is replaced without notifying its owner
+	TimingTable = NewTimingTable;
+	PlayingMontage = Montage;
+	OnMontageEnded = InOnMontageEnded;
+
+	StartSection(0);
+	SetComponentTickEnabled(true);
+
+	return true;
+}
+
+void UCombatAttackTimelineComponent::JumpToSection(FName SectionName, const UAnimMontage* Montage)
+{
+	// ignore jumps for montages we're not playing
+	if (!IsPlaying() || Montage != PlayingMontage)
+	{
+		return;
+	}
+
+	const int32 NewSectionIndex = TimingTable->FindSection(SectionName);
+
+	if (NewSectionIndex != INDEX_NONE)
+	{
+		StartSection(NewSectionIndex);
+	}
+}
+
+void UCombatAttackTimelineComponent::Stop()
+{
+	if (IsPlaying())
+	{
+		FinishPlaying(true);
+	}
+}
+
+void UCombatAttackTimelineComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	float NewPosition = SectionPosition + DeltaTime * PlayingMontage->RateScale;
+
+	// bound the number of sections we can go through in one frame in case of zero length loops
+	for (int32 SectionsPlayed = 0; IsPlaying() && SectionsPlayed <= TimingTable->Sections.Num(); ++SectionsPlayed)
+	{
+		const FCombatAttackSectionTiming& Section = TimingTable->Sections[SectionIndex];
+		const int32 PlayingSectionIndex = SectionIndex;
+
+		// dispatch every event we passed
+		while (NextEventIndex < Section.Events.Num() && Section.Events[NextEventIndex].Time <= NewPosition)
+		{
+			DispatchEvent(NextEventIndex++);
+
+			// did the event jump to another section or stop the montage? Continue from there next frame, like a montage jump
+			if (!IsPlaying() || SectionIndex != PlayingSectionIndex || NextEventIndex == 0)
+			{
+				return;
+			}
+		}
+
+		// are we still inside this section?
+		if (NewPosition < Section.Length)
+		{
+			SectionPosition = NewPosition;
+			return;
+		}
+
+		// have we reached the end of the montage?
+		if (Section.NextSectionIndex == INDEX_NONE)
+		{
+			FinishPlaying(false);
+			return;
+		}
+
+		// carry the leftover time into the next section
+		NewPosition -= Section.Length;
+		StartSection(Section.NextSectionIndex);
+	}
+}
+
+void UCombatAttackTimelineComponent::DispatchEvent(int32 EventIndex)
+{
+	ICombatAttacker* Attacker = Cast<ICombatAttacker>(GetOwner());
+
+	if (!Attacker)
+	{
+		return;
+	}
+
+	// copy the event, the owner may jump to another section
+	const FCombatAttackTimingEvent Event = TimingTable->Sections[SectionIndex].Events[EventIndex];
+
+	switch (Event.Type)
+	{
+	case ECombatAttackTimingEventType::AttackTrace:
+
+		// trace from where the bone would be if the mesh was animated
+		if (const ACharacter* Character = Cast<ACharacter>(GetOwner()))
+		{
+			Attacker->DoAttackTraceFromLocation(Character->GetMesh()->GetComponentTransform().TransformPosition(Event.BoneOffset));
+		}
+		break;
+
+	case ECombatAttackTimingEventType::CheckCombo:
+
+		Attacker->CheckCombo();
+		break;
+
+	case ECombatAttackTimingEventType::CheckChargedAttack:
+
+		Attacker->CheckChargedAttack();
+		break;
+	}
+}
+
+void UCombatAttackTimelineComponent::StartSection(int32 NewSectionIndex)
+{
+	SectionIndex = NewSectionIndex;
+	SectionPosition = 0.0f;
+	NextEventIndex = 0;
+}
+
+void UCombatAttackTimelineComponent::FinishPlaying(bool bInterrupted)
+{
+	UAnimMontage* EndedMontage = PlayingMontage;
+	const FOnMontageEnded EndedDelegate = OnMontageEnded;
+
+	// reset the playback state before the owner gets a chance to play another montage
+	TimingTable = nullptr;
+	PlayingMontage = nullptr;
+	SectionIndex = INDEX_NONE;
+	OnMontageEnded.Unbind();
+
+	SetComponentTickEnabled(false);
+
+	EndedDelegate.ExecuteIfBound(EndedMontage, bInterrupted);
+}
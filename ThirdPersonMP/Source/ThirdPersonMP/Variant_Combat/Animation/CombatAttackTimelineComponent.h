@@ -0,0 +1,82 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "Animation/AnimInstance.h"
+#include "CombatAttackTimelineComponent.generated.h"
+
+class UAnimMontage;
+struct FCombatAttackTimingTable;
+
+/**
+ *  Plays attack montages from their baked timing tables instead of through the AnimInstance.
+ *  Attack notifies are dispatched to the owning ICombatAttacker at their baked times, and attack traces
+ *  start at the baked bone location, so dedicated servers can run attacks without evaluating skeletal animation.
+ *  When in use, the owner's mesh is set to only tick its pose when rendered, which never happens on a server.
+ */
+UCLASS(ClassGroup=(Combat), meta=(BlueprintSpawnableComponent))
+class UCombatAttackTimelineComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+	/** Baked timing of the montage being played */
+	const FCombatAttackTimingTable* TimingTable = nullptr;
+
+	/** Montage being played */
+	UPROPERTY(Transient)
+	TObjectPtr<UAnimMontage> PlayingMontage;
+
+	/** Index of the section being played */
+	int32 SectionIndex = INDEX_NONE;
+
+	/** Playback position inside the current section */
+	float SectionPosition = 0.0f;
+
+	/** Index of the next event to dispatch in the current section */
+	int32 NextEventIndex = 0;
+
+	/** Called when the montage finishes playing or is interrupted */
+	FOnMontageEnded OnMontageEnded;
+
+	/** If true, attacks are played from baked timing on this owner */
+	bool bUseBakedTiming = false;
+
+public:
+
+	/** Constructor */
+	UCombatAttackTimelineComponent();
+
+	/** Returns true if the owner should play its attack montages through this component */
+	bool IsUsingBakedTiming() const { return bUseBakedTiming; }
+
+	/** Plays the montage from its first section. Returns false if the montage has no timing */
+	bool Play(UAnimMontage* Montage, const FOnMontageEnded& InOnMontageEnded);
+
+	/** Jumps to the named section of the montage being played */
+	void JumpToSection(FName SectionName, const UAnimMontage* Montage);
+
+	/** Stops the montage being played and calls the ended delegate */
+	void Stop();
+
+	/** Returns true if a montage is being played */
+	bool IsPlaying() const { return TimingTable != nullptr; }
+
+protected:
+
+	/** Decides whether the owner plays its attacks from baked timing */
+	virtual void BeginPlay() override;
+
+	/** Advances playback and dispatches the notifies */
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	/** Dispatches the event to the owner */
+	void DispatchEvent(int32 EventIndex);
+
+	/** Starts playing the section at the given index */
+	void StartSection(int32 NewSectionIndex);
+
+	/** Ends playback and calls the ended delegate */
+	void FinishPlaying(bool bInterrupted);
+};
@@ -0,0 +1,367 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatAttackTiming.h"
+#include "Animation/AnimMontage.h"
+#include "Animation/AnimSequence.h"
+#include "Animation/Skeleton.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/SkeletalMeshSocket.h"
+#include "AnimNotify_DoAttackTrace.h"
+#include "AnimNotify_CheckCombo.h"
+#include "AnimNotify_CheckChargedAttack.h"
+#include "ThirdPersonMP.h"
+#include "Animation/AnimNotifyQueue.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Baked Attack Timing Tables"), STAT_BakedAttackTimingTables, STATGROUP_ThirdPersonMP);
+
+namespace CombatAttackTiming
+{
+	/** An animation sampled at a montage position */
+	struct FSampledAnimation
+	{
+		const UAnimSequence* Sequence = nullptr;
+		double AnimPosition = 0.0;
+	};
+
+	/**
+	 *  Samples the component space location of a bone or socket at the given montage position.
+	 *  Every slot track is sampled: the first full animation playing replaces the reference pose and local space additive
+	 *  animations are layered on top, then the result is weighted by the montage's blend in. The anim blueprint's own pose
+	 *  isn't known when baking, so the reference pose stands in for it, as it does for any slot the anim blueprint masks out.
+	 */
+	static FVector SampleBoneOffset(const UAnimMontage* Montage, const USkeletalMesh* Mesh, FName BoneOrSocketName, float MontagePosition)
+	{
+		const FReferenceSkeleton& RefSkeleton = Mesh->GetRefSkeleton();
+
+		// resolve sockets to their bone
+		FName BoneName = BoneOrSocketName;
+		FTransform ComponentSpaceTransform = FTransform::Identity;
+
+		if (const USkeletalMeshSocket* Socket = Mesh->FindSocket(BoneOrSocketName))
+		{
+			BoneName = Socket->BoneName;
+			ComponentSpaceTransform = Socket->GetSocketLocalTransform();
+		}
+
+		const int32 BoneIndex = RefSkeleton.FindBoneIndex(BoneName);
+		if (BoneIndex == INDEX_NONE)
+		{
+			UE_LOG(LogThirdPersonMP, Warning, TEXT("Bone %s not found on %s when baking %s"), *BoneOrSocketName.ToString(), *Mesh->GetName(), *Montage->GetName());
+			return FVector::ZeroVector;
+		}
+
+		// find the animations playing at that position on every slot track
+		FSampledAnimation BaseAnimation;
+		TArray<FSampledAnimation, TInlineAllocator<4>> AdditiveAnimations;
+
+		for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+		{
+			const FAnimSegment* Segment = SlotTrack.AnimTrack.GetSegmentAtTime(MontagePosition);
+			const UAnimSequence* Sequence = Segment ? Cast<UAnimSequence>(Segment->GetAnimReference()) : nullptr;
+
+			if (!Sequence)
+			{
+				continue;
+			}
+
+			const FSampledAnimation Sampled{ Sequence, Segment->ConvertTrackPosToAnimPos(MontagePosition) };
+
+			if (!Sequence->IsValidAdditive())
+			{
+				if (!BaseAnimation.Sequence)
+				{
+					BaseAnimation = Sampled;
+				}
+			}
+			else if (Sequence->GetAdditiveAnimType() == AAT_LocalSpaceBase)
+			{
+				AdditiveAnimations.Add(Sampled);
+			}
+		}
+
+		// how far the montage has blended in at that position
+		const float BlendInTime = Montage->BlendIn.GetBlendTime();
+		const float BlendInAlpha = BlendInTime > 0.0f ? FMath::Clamp(MontagePosition / BlendInTime, 0.0f, 1.0f) : 1.0f;
+		const float BlendWeight = FAlphaBlend::AlphaToBlendOption(BlendInAlpha, Montage->BlendIn.GetBlendOption(), Montage->BlendIn.GetCustomCurve());
+
+		const USkeleton* Skeleton = Mesh->GetSkeleton();
+
+		// accumulate the local bone transforms up to the root, falling back to the reference pose for bones the animations don't have
+		for (int32 CurrentIndex = BoneIndex; CurrentIndex != INDEX_NONE; CurrentIndex = RefSkeleton.GetParentIndex(CurrentIndex))
+		{
+			const FTransform& RefTransform = RefSkeleton.GetRefBonePose()[CurrentIndex];
+			FTransform LocalTransform = RefTransform;
+
+			const int32 SkeletonBoneIndex = Skeleton ? Skeleton->GetSkeletonBoneIndexFromMeshBoneIndex(Mesh, CurrentIndex) : INDEX_NONE;
+
+			if (SkeletonBoneIndex != INDEX_NONE)
+			{
+				if (BaseAnimation.Sequence)
+				{
+					BaseAnimation.Sequence->GetBoneTransform(LocalTransform, FSkeletonPoseBoneIndex(SkeletonBoneIndex), BaseAnimation.AnimPosition, false);
+				}
+
+				for (const FSampledAnimation& Additive : AdditiveAnimations)
+				{
+					FTransform AdditiveTransform;
+					Additive.Sequence->GetBoneTransform(AdditiveTransform, FSkeletonPoseBoneIndex(SkeletonBoneIndex), Additive.AnimPosition, false);
+					FTransform::BlendFromIdentityAndAccumulate(LocalTransform, AdditiveTransform, ScalarOne);
+				}
+
+				if (BlendWeight < 1.0f)
+				{
+					LocalTransform.Blend(RefTransform, FTransform(LocalTransform), BlendWeight);
+				}
+			}
+
+			ComponentSpaceTransform = ComponentSpaceTransform * LocalTransform;
+		}
+
+		return ComponentSpaceTransform.GetLocation();
+	}
+
+	/** Adds an attack notify at the given montage position to the table. Other notifies are ignored */
+	static void AddEvent(const UAnimMontage* Montage, const USkeletalMesh* Mesh, const UAnimNotify* Notify, float MontagePosition, FCombatAttackTimingTable& Table)
+	{
+		FCombatAttackTimingEvent Event;
+
+		if (const UAnimNotify_DoAttackTrace* AttackTraceNotify = Cast<UAnimNotify_DoAttackTrace>(Notify))
+		{
+			Event.Type = ECombatAttackTimingEventType::AttackTrace;
+			Event.BoneName = AttackTraceNotify->GetAttackBoneName();
+			Event.BoneOffset = SampleBoneOffset(Montage, Mesh, Event.BoneName, MontagePosition);
+		}
+		else if (Cast<UAnimNotify_CheckCombo>(Notify))
+		{
+			Event.Type = ECombatAttackTimingEventType::CheckCombo;
+		}
+		else if (Cast<UAnimNotify_CheckChargedAttack>(Notify))
+		{
+			Event.Type = ECombatAttackTimingEventType::CheckChargedAttack;
+		}
+		else
+		{
+			return;
+		}
+
+		const int32 SectionIndex = Montage->GetSectionIndexFromPosition(MontagePosition);
+		if (!Table.Sections.IsValidIndex(SectionIndex))
+		{
+			return;
+		}
+
+		float SectionStartTime = 0.0f;
+		float SectionEndTime = 0.0f;
+		Montage->GetSectionStartAndEndTime(SectionIndex, SectionStartTime, SectionEndTime);
+
+		Event.Time = MontagePosition - SectionStartTime;
+		Table.Sections[SectionIndex].Events.Add(Event);
+	}
+
+	/** Bakes the montage's sections and attack notifies */
+	static void BakeTimingTable(const UAnimMontage* Montage, const USkeletalMesh* Mesh, FCombatAttackTimingTable& Table)
+	{
+		// copy the section layout
+		for (int32 SectionIndex = 0; SectionIndex < Montage->CompositeSections.Num(); ++SectionIndex)
+		{
+			float SectionStartTime = 0.0f;
+			float SectionEndTime = 0.0f;
+			Montage->GetSectionStartAndEndTime(SectionIndex, SectionStartTime, SectionEndTime);
+
+			FCombatAttackSectionTiming& Section = Table.Sections.AddDefaulted_GetRef();
+			Section.SectionName = Montage->CompositeSections[SectionIndex].SectionName;
+			Section.Length = SectionEndTime - SectionStartTime;
+		}
+
+		for (int32 SectionIndex = 0; SectionIndex < Montage->CompositeSections.Num(); ++SectionIndex)
+		{
+			Table.Sections[SectionIndex].NextSectionIndex = Montage->GetSectionIndex(Montage->CompositeSections[SectionIndex].NextSectionName);
+		}
+
+		// notifies placed on the montage
+		for (const FAnimNotifyEvent& NotifyEvent : Montage->Notifies)
+		{
+			AddEvent(Montage, Mesh, NotifyEvent.Notify, NotifyEvent.GetTriggerTime(), Table);
+		}
+
+		// notifies placed on the animations the montage plays, on every slot like montage playback
+		for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+		{
+			for (const FAnimSegment& Segment : SlotTrack.AnimTrack.AnimSegments)
+			{
+				const UAnimSequenceBase* Animation = Segment.GetAnimReference();
+				if (!Animation || Segment.AnimPlayRate <= 0.0f)
+				{
+					continue;
+				}
+
+				const float LoopLength = Segment.AnimEndTime - Segment.AnimStartTime;
+
+				for (const FAnimNotifyEvent& NotifyEvent : Animation->Notifies)
+				{
+					const float NotifyTime = NotifyEvent.GetTriggerTime();
+					if (NotifyTime < Segment.AnimStartTime || NotifyTime >= Segment.AnimEndTime)
+					{
+						continue;
+					}
+
+					for (int32 Loop = 0; Loop < FMath::Max(Segment.LoopingCount, 1); ++Loop)
+					{
+						const float MontagePosition = Segment.StartPos + (Loop * LoopLength + NotifyTime - Segment.AnimStartTime) / Segment.AnimPlayRate;
+						AddEvent(Montage, Mesh, NotifyEvent.Notify, MontagePosition, Table);
+					}
+				}
+			}
+		}
+
+		// events are consumed in order during playback
+		for (FCombatAttackSectionTiming& Section : Table.Sections)
+		{
+			Section.Events.StableSort([](const FCombatAttackTimingEvent& A, const FCombatAttackTimingEvent& B) { return A.Time < B.Time; });
+		}
+	}
+}
+
+int32 FCombatAttackTimingTable::FindSection(FName SectionName) const
+{
+	return Sections.IndexOfByPredicate([SectionName](const FCombatAttackSectionTiming& Section) { return Section.SectionName == SectionName; });
+}
+
+const FCombatAttackTimingTable* UCombatAttackTimingSubsystem::GetTimingTable(const UAnimMontage* Montage, const USkeletalMesh* Mesh)
+{
+	if (!Montage || !Mesh)
+	{
+		return nullptr;
+	}
+
+	const TPair<TObjectKey<UAnimMontage>, TObjectKey<USkeletalMesh>> Key(Montage, Mesh);
+
+	// have we baked this montage already?
+	if (const TSharedPtr<FCombatAttackTimingTable>* ExistingTable = TimingTables.Find(Key))
+	{
+		return ExistingTable->Get();
+	}
+
+	// montages without sections can't be scheduled
+	TSharedPtr<FCombatAttackTimingTable> Table;
+
+	if (Montage->CompositeSections.Num() > 0)
+	{
+		Table = MakeShared<FCombatAttackTimingTable>();
+		CombatAttackTiming::BakeTimingTable(Montage, Mesh, *Table);
+		INC_DWORD_STAT(STAT_BakedAttackTimingTables);
+	}
+
+	TimingTables.Add(Key, Table);
+	return Table.Get();
+}
+
+void UCombatAttackTimingSubsystem::Deinitialize()
+{
+	for (const TPair<TPair<TObjectKey<UAnimMontage>, TObjectKey<USkeletalMesh>>, TSharedPtr<FCombatAttackTimingTable>>& Pair : TimingTables)
+	{
+		if (Pair.Value.IsValid())
+		{
+			DEC_DWORD_STAT(STAT_BakedAttackTimingTables);
+		}
+	}
+
+	TimingTables.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UCombatAttackTimingSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+#if !UE_BUILD_SHIPPING
+
+namespace CombatAttackTiming
+{
+	/** Counts the attack traces an attack interrupted at the given time fires when played from baked timing and when animated */
+	static void CompareInterruptedAttackTraces(const TArray<FString>& Args, UWorld* World)
+	{
+		if (Args.Num() < 3 || !World)
+		{
+			UE_LOG(LogThirdPersonMP, Display, TEXT("Usage: Combat.CompareInterruptedAttackTraces <Montage path> <Skeletal mesh path> <Interrupt time>"));
+			return;
+		}
+
+		const UAnimMontage* Montage = LoadObject<UAnimMontage>(nullptr, *Args[0]);
+		const USkeletalMesh* Mesh = LoadObject<USkeletalMesh>(nullptr, *Args[1]);
+		const float InterruptTime = FCString::Atof(*Args[2]);
+		UCombatAttackTimingSubsystem* TimingSubsystem = World->GetSubsystem<UCombatAttackTimingSubsystem>();
+		const FCombatAttackTimingTable* Table = Montage && Mesh && TimingSubsystem ? TimingSubsystem->GetTimingTable(Montage, Mesh) : nullptr;
+
+		if (!Table)
+		{
+			UE_LOG(LogThirdPersonMP, Warning, TEXT("No attack timing for %s on %s"), *Args[0], *Args[1]);
+			return;
+		}
+
+		int32 BakedTraces = 0;
+		int32 AnimatedTraces = 0;
+		float Elapsed = 0.0f;
+
+		// follow the default section order until the interrupt, bounded in case of loops
+		int32 SectionIndex = 0;
+		for (int32 SectionsPlayed = 0; Table->Sections.IsValidIndex(SectionIndex) && Elapsed < InterruptTime && SectionsPlayed <= Table->Sections.Num(); ++SectionsPlayed)
+		{
+			const FCombatAttackSectionTiming& Section = Table->Sections[SectionIndex];
+			const float PlayedTime = FMath::Min(Section.Length, InterruptTime - Elapsed);
+
+			// the timeline dispatches every event it passed before being stopped
+			for (const FCombatAttackTimingEvent& Event : Section.Events)
+			{
+				if (Event.Type == ECombatAttackTimingEventType::AttackTrace && Event.Time <= PlayedTime)
+				{
+					++BakedTraces;
+				}
+			}
+
+			// the montage fires the notifies of the montage and its slot animations it advanced over
+			float SectionStartTime = 0.0f;
+			float SectionEndTime = 0.0f;
+			Montage->GetSectionStartAndEndTime(SectionIndex, SectionStartTime, SectionEndTime);
+
+			FAnimNotifyContext NotifyContext;
+			Montage->UAnimSequenceBase::GetAnimNotifiesFromDeltaPositions(SectionStartTime, SectionStartTime + PlayedTime, NotifyContext);
+
+			for (const FSlotAnimationTrack& SlotTrack : Montage->SlotAnimTracks)
+			{
+				SlotTrack.AnimTrack.GetAnimNotifiesFromTrackPositions(SectionStartTime, SectionStartTime + PlayedTime, NotifyContext);
+			}
+
+			for (const FAnimNotifyEventReference& NotifyReference : NotifyContext.ActiveNotifies)
+			{
+				const FAnimNotifyEvent* NotifyEvent = NotifyReference.GetNotify();
+				if (NotifyEvent && Cast<UAnimNotify_DoAttackTrace>(NotifyEvent->Notify))
+				{
+					++AnimatedTraces;
+				}
+			}
+
+			Elapsed += Section.Length;
+			SectionIndex = Section.NextSectionIndex;
+		}
+
+		UE_LOG(LogThirdPersonMP, Display, TEXT("%s interrupted at %.2fs: %d baked attack traces, %d animated"), *Montage->GetName(), InterruptTime, BakedTraces, AnimatedTraces);
+
+		if (BakedTraces != AnimatedTraces)
+		{
+			UE_LOG(LogThirdPersonMP, Warning, TEXT("Baked and animated attack trace counts differ for %s"), *Montage->GetName());
+		}
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs CCmdCompareInterruptedAttackTraces(
+	TEXT("Combat.CompareInterruptedAttackTraces"),
+	TEXT("Compares the attack traces fired by a montage interrupted at a given time when played from baked timing and when animated. Args: <Montage path> <Skeletal mesh path> <Interrupt time>"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&CombatAttackTiming::CompareInterruptedAttackTraces));
+
+#endif
@@ -0,0 +1,100 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CombatAttackTiming.generated.h"
+
+class UAnimMontage;
+class USkeletalMesh;
+
+/**
+ *  Attack AnimNotify types that can be replayed without animation
+ */
+enum class ECombatAttackTimingEventType : uint8
+{
+	AttackTrace,
+	CheckCombo,
+	CheckChargedAttack
+};
+
+/**
+ *  A single attack AnimNotify baked from a montage
+ */
+struct FCombatAttackTimingEvent
+{
+	/** Type of notify */
+	ECombatAttackTimingEventType Type = ECombatAttackTimingEventType::AttackTrace;
+
+	/** Time of the notify, relative to the start of its section */
+	float Time = 0.0f;
+
+	/** Source bone or socket of an attack trace */
+	FName BoneName;
+
+	/** Location of the source bone in mesh component space at the notify time */
+	FVector BoneOffset = FVector::ZeroVector;
+};
+
+/**
+ *  Timing of a single montage section
+ */
+struct FCombatAttackSectionTiming
+{
+	/** Name of the montage section */
+	FName SectionName;
+
+	/** Length of the section */
+	float Length = 0.0f;
+
+	/** Index of the section that plays after this one, INDEX_NONE if the montage ends */
+	int32 NextSectionIndex = INDEX_NONE;
+
+	/** Attack notifies in this section, sorted by time */
+	TArray<FCombatAttackTimingEvent> Events;
+};
+
+/**
+ *  Section layout and attack notifies of a montage played on a given skeletal mesh.
+ *  Lets servers schedule attack traces without evaluating skeletal animation.
+ */
+struct FCombatAttackTimingTable
+{
+	/** Montage sections, in the montage's section order */
+	TArray<FCombatAttackSectionTiming> Sections;
+
+	/** Returns the index of the named section, or INDEX_NONE */
+	int32 FindSection(FName SectionName) const;
+};
+
+/**
+ *  Bakes and caches attack timing tables from montages.
+ *  Tables are baked once per montage and skeletal mesh from the montage's sections and notifies,
+ *  sampling the source bone pose of each attack trace from the montage's slot animations, with the reference pose
+ *  standing in for the anim blueprint's own pose.
+ */
+UCLASS()
+class UCombatAttackTimingSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Releases the baked tables */
+	virtual void Deinitialize() override;
+
+	/** Returns the timing table for the montage played on the mesh, baking it on first use. Returns nullptr if the montage can't be baked */
+	const FCombatAttackTimingTable* GetTimingTable(const UAnimMontage* Montage, const USkeletalMesh* Mesh);
+
+protected:
+
+	/** Only game worlds run attacks */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+
+	/** Baked tables, keyed by montage and skeletal mesh */
+	TMap<TPair<TObjectKey<UAnimMontage>, TObjectKey<USkeletalMesh>>, TSharedPtr<FCombatAttackTimingTable>> TimingTables;
+};
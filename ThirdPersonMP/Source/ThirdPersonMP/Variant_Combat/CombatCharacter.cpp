@@ -3,18 +3,23 @@
 
 #include "CombatCharacter.h"
 #include "Components/CapsuleComponent.h"
-#include "Components/WidgetComponent.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "GameFramework/SpringArmComponent.h"
 #include "Components/SkeletalMeshComponent.h"
 #include "Camera/CameraComponent.h"
 #include "EnhancedInputSubsystems.h"
 #include "EnhancedInputComponent.h"
-#include "CombatLifeBar.h"
+#include "CombatLifeBarSubsystem.h"
 #include "Engine/DamageEvents.h"
 #include "TimerManager.h"
 #include "Engine/LocalPlayer.h"
 #include "CombatPlayerController.h"
+#include "HealthComponent.h"
+#include "ClientOnlyComponents.h"
+#include "CombatAttackTimelineComponent.h"
+#include "CombatTraceSubsystem.h"
+#include "CombatRagdollSubsystem.h"
+#include "ThirdPersonMP.h"
 
 ACombatCharacter::ACombatCharacter()
 {
@@ -29,23 +34,34 @@ ACombatCharacter::ACombatCharacter()
 	// Configure character movement
 	GetCharacterMovement()->MaxWalkSpeed = 400.0f;
 
+	// cameras are only needed where somebody looks through them, they are stripped in PostInitializeComponents on dedicated servers
+
 	// create the camera boom
-	CameraBoom = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
-	CameraBoom->SetupAttachment(RootComponent);
+	CameraBoom = CreateOptionalDefaultSubobject<USpringArmComponent>(TEXT("CameraBoom"));
+	if (CameraBoom)
+	{
+		CameraBoom->SetupAttachment(RootComponent);
 
-	CameraBoom->TargetArmLength = DefaultCameraDistance;
-	CameraBoom->bUsePawnControlRotation = true;
-	CameraBoom->bEnableCameraLag = true;
-	CameraBoom->bEnableCameraRotationLag = true;
+		CameraBoom->TargetArmLength = DefaultCameraDistance;
+		CameraBoom->bUsePawnControlRotation = true;
+		CameraBoom->bEnableCameraLag = true;
+		CameraBoom->bEnableCameraRotationLag = true;
+	}
 
 	// create the orbiting camera
-	FollowCamera = CreateDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
-	FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
-	FollowCamera->bUsePawnControlRotation = false;
+	FollowCamera = CreateOptionalDefaultSubobject<UCameraComponent>(TEXT("FollowCamera"));
+	if (FollowCamera && CameraBoom)
+	{
+		FollowCamera->SetupAttachment(CameraBoom, USpringArmComponent::SocketName);
+		FollowCamera->bUsePawnControlRotation = false;
+	}
+
+	// create the health component
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComponent"));
+	HealthComponent->MaxHealth = 5.0f;
 
-	// create the life bar widget component
-	LifeBar = CreateDefaultSubobject<UWidgetComponent>(TEXT("LifeBar"));
-	LifeBar->SetupAttachment(RootComponent);
+	// create the attack timeline, used to play attacks without animation on dedicated servers
+	AttackTimeline = CreateDefaultSubobject<UCombatAttackTimelineComponent>(TEXT("AttackTimeline"));
 
 	// set the player tag
 	Tags.Add(FName("Player"));
@@ -167,10 +183,13 @@ void ACombatCharacter::DoChargedAttackEnd()
 void ACombatCharacter::ResetHP()
 {
 	// reset the current HP total
-	CurrentHP = MaxHP;
+	HealthComponent->ResetHealth();
 
 	// update the life bar
-	LifeBarWidget->SetLifePercentage(1.0f);
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifePercentage(this, 1.0f);
+	}
 }
 
 void ACombatCharacter::ComboAttack()
@@ -182,17 +201,7 @@ void ACombatCharacter::ComboAttack()
 	ComboCount = 0;
 
 	// play the attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		const float MontageLength = AnimInstance->Montage_Play(ComboAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
-
-		// subscribe to montage completed and interrupted events
-		if (MontageLength > 0.0f)
-		{
-			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ComboAttackMontage);
-		}
-	}
+	PlayAttackMontage(ComboAttackMontage);
 
 }
 
@@ -205,17 +214,59 @@ void ACombatCharacter::ChargedAttack()
 	bHasLoopedChargedAttack = false;
 
 	// play the charged attack montage
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	PlayAttackMontage(ChargedAttackMontage);
+}
+
+void ACombatCharacter::PlayAttackMontage(UAnimMontage* Montage)
+{
+	// start a new swing so targets can be hit again
+	++AttackSwingId;
+
+	// dedicated servers play the attack from its baked timing
+	if (AttackTimeline->IsUsingBakedTiming())
+	{
+		if (AttackTimeline->Play(Montage, OnAttackMontageEnded))
+		{
+			return;
+		}
+	}
+	else if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
 	{
-		const float MontageLength = AnimInstance->Montage_Play(ChargedAttackMontage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
+		// play the attack montage
+		const float MontageLength = AnimInstance->Montage_Play(Montage, 1.0f, EMontagePlayReturnType::MontageLength, 0.0f, true);
 
 		// subscribe to montage completed and interrupted events
 		if (MontageLength > 0.0f)
 		{
 			// set the end delegate for the montage
-			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, ChargedAttackMontage);
+			AnimInstance->Montage_SetEndDelegate(OnAttackMontageEnded, Montage);
+			return;
 		}
 	}
+
+	// the attack couldn't start, so no end event will lower the attacking flag
+	UE_LOG(LogThirdPersonMP, Warning, TEXT("%s couldn't play attack montage %s"), *GetName(), *GetNameSafe(Montage));
+
+	// don't go through AttackMontageEnded, a buffered attack input would only try the same montage again
+	bIsAttacking = false;
+}
+
+void ACombatCharacter::JumpToAttackSection(FName SectionName, UAnimMontage* Montage)
+{
+	// every section is a new swing
+	++AttackSwingId;
+
+	// dedicated servers play the attack from its baked timing
+	if (AttackTimeline->IsUsingBakedTiming())
+	{
+		AttackTimeline->JumpToSection(SectionName, Montage);
+		return;
+	}
+
+	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
+	{
+		AnimInstance->Montage_JumpToSection(SectionName, Montage);
+	}
 }
 
 void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted)
@@ -242,45 +293,54 @@ void ACombatCharacter::AttackMontageEnded(UAnimMontage* Montage, bool bInterrupt
 
 void ACombatCharacter::DoAttackTrace(FName DamageSourceBone)
 {
-	// sweep for objects in front of the character to be hit by the attack
-	TArray<FHitResult> OutHits;
+	// start at the provided socket location
+	DoAttackTraceFromLocation(GetMesh()->GetSocketLocation(DamageSourceBone));
+}
 
-	// start at the provided socket location, sweep forward
-	const FVector TraceStart = GetMesh()->GetSocketLocation(DamageSourceBone);
-	const FVector TraceEnd = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+void ACombatCharacter::DoAttackTraceFromLocation(const FVector& TraceStart)
+{
+	UCombatTraceSubsystem* CombatTrace = GetWorld()->GetSubsystem<UCombatTraceSubsystem>();
 
-	// check for pawn and world dynamic collision object types
-	FCollisionObjectQueryParams ObjectParams;
-	ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
-	ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
+	if (!CombatTrace)
+	{
+		return;
+	}
 
-	// use a sphere shape for the sweep
-	FCollisionShape CollisionShape;
-	CollisionShape.SetSphere(MeleeTraceRadius);
+	// sweep a sphere forward from the trace start
+	FCombatSweepRequest Request;
+	Request.Attacker = this;
+	Request.SwingId = AttackSwingId;
+	Request.Start = TraceStart;
+	Request.End = TraceStart + (GetActorForwardVector() * MeleeTraceDistance);
+	Request.Radius = MeleeTraceRadius;
 
-	// ignore self
-	FCollisionQueryParams QueryParams;
-	QueryParams.AddIgnoredActor(this);
+	// check for pawn and world dynamic collision object types
+	Request.ObjectParams.AddObjectTypesToQuery(ECC_Pawn);
+	Request.ObjectParams.AddObjectTypesToQuery(ECC_WorldDynamic);
 
-	if (GetWorld()->SweepMultiByObjectType(OutHits, TraceStart, TraceEnd, FQuat::Identity, ObjectParams, CollisionShape, QueryParams))
+	// the hits are resolved once the batched sweep comes back
+	Request.OnResolved.BindUObject(this, &ACombatCharacter::ResolveAttackHits);
+	CombatTrace->QueueSweep(MoveTemp(Request));
+}
+
+void ACombatCharacter::ResolveAttackHits(const TArray<FHitResult>& Hits)
+{
+	// iterate over each object hit
+	for (const FHitResult& CurrentHit : Hits)
 	{
-		// iterate over each object hit
-		for (const FHitResult& CurrentHit : OutHits)
-		{
-			// check if we've hit a damageable actor
-			ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
+		// check if we've hit a damageable actor
+		ICombatDamageable* Damageable = Cast<ICombatDamageable>(CurrentHit.GetActor());
 
-			if (Damageable)
-			{
-				// knock upwards and away from the impact normal
-				const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
+		if (Damageable)
+		{
+			// knock upwards and away from the impact normal
+			const FVector Impulse = (CurrentHit.ImpactNormal * -MeleeKnockbackImpulse) + (FVector::UpVector * MeleeLaunchImpulse);
 
-				// pass the damage event to the actor
-				Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
+			// pass the damage event to the actor
+			Damageable->ApplyDamage(MeleeDamage, this, CurrentHit.ImpactPoint, Impulse);
 
-				// call the BP handler to play effects, etc.
-				DealtDamage(MeleeDamage, CurrentHit.ImpactPoint);
-			}
+			// call the BP handler to play effects, etc.
+			DealtDamage(MeleeDamage, CurrentHit.ImpactPoint);
 		}
 	}
 }
@@ -303,10 +363,7 @@ void ACombatCharacter::CheckCombo()
 			if (ComboCount < ComboSectionNames.Num())
 			{
 				// jump to the next combo section
-				if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-				{
-					AnimInstance->Montage_JumpToSection(ComboSectionNames[ComboCount], ComboAttackMontage);
-				}
+				JumpToAttackSection(ComboSectionNames[ComboCount], ComboAttackMontage);
 			}
 		}
 	}
@@ -318,10 +375,7 @@ void ACombatCharacter::CheckChargedAttack()
 	bHasLoopedChargedAttack = true;
 
 	// jump to either the loop or the attack section depending on whether we're still holding the charge button
-	if (UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance())
-	{
-		AnimInstance->Montage_JumpToSection(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection, ChargedAttackMontage);
-	}
+	JumpToAttackSection(bIsChargingAttack ? ChargeLoopSection : ChargeAttackSection, ChargedAttackMontage);
 }
 
 void ACombatCharacter::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
@@ -354,14 +408,36 @@ void ACombatCharacter::HandleDeath()
 	// disable movement while we're dead
 	GetCharacterMovement()->DisableMovement();
 
-	// enable full ragdoll physics
-	GetMesh()->SetSimulatePhysics(true);
+	// the death animation or ragdoll ends an animated attack, a baked one has to be stopped
+	if (AttackTimeline->IsUsingBakedTiming())
+	{
+		// drop any buffered attack so ending this one doesn't start another
+		CachedAttackInputTime = 0.0f;
+
+		AttackTimeline->Stop();
+	}
+
+	// ragdoll if the budget allows, otherwise play the death animation
+	if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+	{
+		Ragdolls->StartDeathRagdoll(this, DeathMontage);
+	}
+	else
+	{
+		GetMesh()->SetSimulatePhysics(true);
+	}
 
 	// hide the life bar
-	LifeBar->SetHiddenInGame(true);
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifeBarVisible(this, false);
+	}
 
 	// pull back the camera
-	GetCameraBoom()->TargetArmLength = DeathCameraDistance;
+	if (CameraBoom)
+	{
+		CameraBoom->TargetArmLength = DeathCameraDistance;
+	}
 
 	// schedule respawning
 	GetWorld()->GetTimerManager().SetTimer(RespawnTimer, this, &ACombatCharacter::RespawnCharacter, RespawnTime, false);
@@ -381,28 +457,33 @@ void ACombatCharacter::RespawnCharacter()
 float ACombatCharacter::TakeDamage(float Damage, struct FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
 {
 	// only process damage if the character is still alive
-	if (CurrentHP <= 0.0f)
+	if (HealthComponent->IsDead())
 	{
 		return 0.0f;
 	}
 
-	// reduce the current HP
-	CurrentHP -= Damage;
+	// reduce the current HP. The life bar is updated once all the damage of this frame is applied
+	HealthComponent->ApplyDamage(Damage);
 
 	// have we run out of HP?
-	if (CurrentHP <= 0.0f)
+	if (HealthComponent->IsDead())
 	{
 		// die
 		HandleDeath();
 	}
 	else
 	{
-		// update the life bar
-		LifeBarWidget->SetLifePercentage(CurrentHP / MaxHP);
-
-		// enable partial ragdoll physics, but keep the pelvis vertical
-		GetMesh()->SetPhysicsBlendWeight(0.5f);
-		GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		// enable partial ragdoll physics if the budget allows
+		if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+		{
+			Ragdolls->StartHitReact(this, PelvisBoneName);
+		}
+		else
+		{
+			// keep the pelvis vertical
+			GetMesh()->SetPhysicsBlendWeight(0.5f);
+			GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+		}
 	}
 
 	// return the received damage amount
@@ -414,40 +495,95 @@ void ACombatCharacter::Landed(const FHitResult& Hit)
 	Super::Landed(Hit);
 
 	// is the character still alive?
-	if (CurrentHP >= 0.0f)
+	if (HealthComponent->GetHealth() >= 0.0f)
 	{
 		// disable ragdoll physics
-		GetMesh()->SetPhysicsBlendWeight(0.0f);
+		if (UCombatRagdollSubsystem* Ragdolls = GetWorld()->GetSubsystem<UCombatRagdollSubsystem>())
+		{
+			Ragdolls->EndHitReact(this);
+		}
+		else
+		{
+			GetMesh()->SetPhysicsBlendWeight(0.0f);
+		}
 	}
 }
 
+void ACombatCharacter::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// move the max HP saved before health moved to the health component
+	if (MaxHP_DEPRECATED >= 0.0f)
+	{
+		HealthComponent->MaxHealth = MaxHP_DEPRECATED;
+		MaxHP_DEPRECATED = -1.0f;
+	}
+#endif
+}
+
+void ACombatCharacter::PostInitializeComponents()
+{
+	Super::PostInitializeComponents();
+
+	// every process constructs the client-only components, so a dedicated server still pays their construction and destruction for every pawn
+	if (ClientOnlyComponents::ShouldStrip(this))
+	{
+		ClientOnlyComponents::Strip(FollowCamera);
+		ClientOnlyComponents::Strip(CameraBoom);
+	}
+
+	ClientOnlyComponents::ReportFootprint(this);
+}
+
 void ACombatCharacter::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// get the life bar from the widget component
-	LifeBarWidget = Cast<UCombatLifeBar>(LifeBar->GetUserWidgetObject());
-	check(LifeBarWidget);
+	// add our life bar to the life bar layer
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->RegisterLifeBar(this, LifeBarColor, LifeBarOffset);
+	}
 
 	// initialize the camera
-	GetCameraBoom()->TargetArmLength = DefaultCameraDistance;
+	if (CameraBoom)
+	{
+		CameraBoom->TargetArmLength = DefaultCameraDistance;
+	}
 
 	// save the relative transform for the mesh so we can reset the ragdoll later
 	MeshStartingTransform = GetMesh()->GetRelativeTransform();
 
-	// set the life bar color
-	LifeBarWidget->SetBarColor(LifeBarColor);
+	// update the life bar whenever the HP change
+	HealthComponent->OnHealthChanged.AddDynamic(this, &ACombatCharacter::OnHealthChanged);
 
 	// reset HP to maximum
 	ResetHP();
 }
 
+void ACombatCharacter::OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth)
+{
+	// update the life bar
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->SetLifePercentage(this, HealthComponent->GetHealthPercent());
+	}
+}
+
 void ACombatCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
 	Super::EndPlay(EndPlayReason);
 
 	// clear the respawn timer
 	GetWorld()->GetTimerManager().ClearTimer(RespawnTimer);
+
+	// remove our life bar
+	if (UCombatLifeBarSubsystem* LifeBars = GetWorld()->GetSubsystem<UCombatLifeBarSubsystem>())
+	{
+		LifeBars->UnregisterLifeBar(this);
+	}
 }
 
 void ACombatCharacter::SetupPlayerInputComponent(UInputComponent* PlayerInputComponent)
@@ -13,8 +13,8 @@ class USpringArmComponent;
 class UCameraComponent;
 class UInputAction;
 struct FInputActionValue;
-class UCombatLifeBar;
-class UWidgetComponent;
+class UHealthComponent;
+class UCombatAttackTimelineComponent;
 
 DECLARE_LOG_CATEGORY_EXTERN(LogCombatCharacter, Log, All);
 
@@ -31,17 +31,21 @@ class ACombatCharacter : public ACharacter, public ICombatAttacker, public IComb
 {
 	GENERATED_BODY()
 
-	/** Camera boom positioning the camera behind the character */
+	/** Camera boom positioning the camera behind the character. Null on dedicated servers */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	USpringArmComponent* CameraBoom;
 
-	/** Follow camera */
+	/** Follow camera. Null on dedicated servers */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	UCameraComponent* FollowCamera;
 
-	/** Life bar widget component */
+	/** Health component, holds the character's HP */
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
-	UWidgetComponent* LifeBar;
+	UHealthComponent* HealthComponent;
+
+	/** Plays attacks from baked montage timing on dedicated servers */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UCombatAttackTimelineComponent* AttackTimeline;
 	
 protected:
 
@@ -69,25 +73,23 @@ protected:
 	UPROPERTY(EditAnywhere, Category ="Input")
 	UInputAction* ChargedAttackAction;
 
-	/** Max amount of HP the character will have on respawn */
-	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 100))
-	float MaxHP = 5.0f;
+#if WITH_EDITORONLY_DATA
+	/** Max HP saved before it moved to the health component, copied to it on load. Negative when unset */
+	UPROPERTY()
+	float MaxHP_DEPRECATED = -1.0f;
+#endif
 
-	/** Current amount of HP the character has */
-	UPROPERTY(VisibleAnywhere, Category="Damage")
-	float CurrentHP = 0.0f;
-
-	/** Life bar widget fill color */
+	/** Life bar fill color */
 	UPROPERTY(EditAnywhere, Category="Damage")
 	FLinearColor LifeBarColor;
 
-	/** Name of the pelvis bone, for damage ragdoll physics */
+	/** Offset from the character's location to its life bar */
 	UPROPERTY(EditAnywhere, Category="Damage")
-	FName PelvisBoneName;
+	FVector LifeBarOffset = FVector(0.0f, 0.0f, 120.0f);
 
-	/** Pointer to the life bar widget */
+	/** Name of the pelvis bone, for damage ragdoll physics */
 	UPROPERTY(EditAnywhere, Category="Damage")
-	TObjectPtr<UCombatLifeBar> LifeBarWidget;
+	FName PelvisBoneName;
 
 	/** Max amount of time that may elapse for a non-combo attack input to not be considered stale */
 	UPROPERTY(EditAnywhere, Category="Melee Attack", meta = (ClampMin = 0, ClampMax = 5, Units = "s"))
@@ -99,6 +101,9 @@ protected:
 	/** If true, the character is currently playing an attack animation */
 	bool bIsAttacking = false;
 
+	/** Identifies the current attack swing. Each target is only hit once per swing */
+	uint32 AttackSwingId = 0;
+
 	/** Distance ahead of the character that melee attack sphere collision traces will extend */
 	UPROPERTY(EditAnywhere, Category="Melee Attack|Trace", meta = (ClampMin = 0, ClampMax = 500, Units="cm"))
 	float MeleeTraceDistance = 75.0f;
@@ -160,6 +165,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Camera", meta = (ClampMin = 0, ClampMax = 1000, Units = "cm"))
 	float DefaultCameraDistance = 100.0f;
 
+	/** Death animation played when the ragdoll budget is full. Should not auto blend out */
+	UPROPERTY(EditAnywhere, Category="Respawn")
+	UAnimMontage* DeathMontage;
+
 	/** Time to wait before respawning the character */
 	UPROPERTY(EditAnywhere, Category="Respawn", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
 	float RespawnTime = 3.0f;
@@ -232,9 +241,22 @@ protected:
 	/** Performs a charged attack */
 	void ChargedAttack();
 
+	/** Plays an attack montage, or its baked timing on dedicated servers */
+	void PlayAttackMontage(UAnimMontage* Montage);
+
+	/** Jumps to a section of the attack montage being played */
+	void JumpToAttackSection(FName SectionName, UAnimMontage* Montage);
+
+	/** Applies damage to the actors hit by an attack sweep */
+	void ResolveAttackHits(const TArray<FHitResult>& Hits);
+
 	/** Called from a delegate when the attack montage ends */
 	void AttackMontageEnded(UAnimMontage* Montage, bool bInterrupted);
 
+	/** Updates the life bar when the HP changed, at most once per frame */
+	UFUNCTION()
+	void OnHealthChanged(UHealthComponent* ChangedHealthComponent, float OldHealth, float NewHealth);
+
 	
 public:
 
@@ -243,6 +265,9 @@ public:
 	/** Performs the collision check for an attack */
 	virtual void DoAttackTrace(FName DamageSourceBone) override;
 
+	/** Performs the collision check for an attack from the given location. Hits are resolved when the batched sweep completes */
+	virtual void DoAttackTraceFromLocation(const FVector& TraceStart) override;
+
 	/** Performs the combo string check */
 	virtual void CheckCombo() override;
 
@@ -287,6 +312,12 @@ protected:
 
 protected:
 
+	/** Migrates health data saved before the health component */
+	virtual void PostLoad() override;
+
+	/** Strips the client-only components on dedicated servers */
+	virtual void PostInitializeComponents() override;
+
 	/** Initialization */
 	virtual void BeginPlay() override;
 
@@ -7,6 +7,7 @@
 #include "Kismet/GameplayStatics.h"
 #include "GameFramework/PlayerStart.h"
 #include "CombatCharacter.h"
+#include "ClientOnlyComponents.h"
 #include "Engine/LocalPlayer.h"
 #include "Engine/World.h"
 #include "Blueprint/UserWidget.h"
@@ -79,7 +80,13 @@ void ACombatPlayerController::SetRespawnTransform(const FTransform& NewRespawn)
 void ACombatPlayerController::OnPawnDestroyed(AActor* DestroyedActor)
 {
 	// spawn a new character at the respawn transform
-	if (ACombatCharacter* RespawnedCharacter = GetWorld()->SpawnActor<ACombatCharacter>(CharacterClass, RespawnTransform))
+	ACombatCharacter* RespawnedCharacter = nullptr;
+	{
+		SCOPE_CYCLE_COUNTER(STAT_CharacterSpawn);
+		RespawnedCharacter = GetWorld()->SpawnActor<ACombatCharacter>(CharacterClass, RespawnTransform);
+	}
+
+	if (RespawnedCharacter)
 	{
 		// possess the character
 		Possess(RespawnedCharacter);
@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatRagdollSubsystem.h"
+#include "GameFramework/Character.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimMontage.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "PlayerTargetSubsystem.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Ragdolls"), STAT_ActiveRagdolls, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Active Hit Reacts"), STAT_ActiveHitReacts, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Ragdolls Denied"), STAT_RagdollsDenied, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Hit Reacts Denied"), STAT_HitReactsDenied, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<int32> CVarCombatRagdollMaxActive(
+	TEXT("Combat.Ragdoll.MaxActive"),
+	6,
+	TEXT("Maximum number of simulated death ragdolls. Deaths over the budget play their death montage instead."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCombatRagdollMaxHitReacts(
+	TEXT("Combat.Ragdoll.MaxHitReacts"),
+	8,
+	TEXT("Maximum number of partial ragdoll hit reactions. Hits over the budget don't blend in physics."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCombatRagdollFreezeTime(
+	TEXT("Combat.Ragdoll.FreezeTime"),
+	3.0f,
+	TEXT("Seconds after which a death ragdoll is put to sleep even if it hasn't settled."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCombatRagdollSleepSpeed(
+	TEXT("Combat.Ragdoll.SleepSpeed"),
+	10.0f,
+	TEXT("Speed in cm/s under which a death ragdoll is considered settled and put to sleep."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCombatRagdollHitReactTimeout(
+	TEXT("Combat.Ragdoll.HitReactTimeout"),
+	1.5f,
+	TEXT("Seconds after which a hit reaction is blended out if the character hasn't landed."),
+	ECVF_Default);
+
+namespace CombatRagdoll
+{
+	/** Minimum time a death ragdoll simulates before it can be considered settled */
+	static constexpr double MinSettleTime = 0.5;
+
+	/** Priority score added per second of ragdoll age, in cm, so older ragdolls are evicted first */
+	static constexpr float AgeScorePerSecond = 500.0f;
+
+	/** Physics blend weight of hit reactions */
+	static constexpr float HitReactBlendWeight = 0.5f;
+}
+
+bool UCombatRagdollSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatRagdollSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatRagdollSubsystem, STATGROUP_Tickables);
+}
+
+bool UCombatRagdollSubsystem::StartDeathRagdoll(ACharacter* Character, UAnimMontage* FallbackMontage)
+{
+	if (!Character)
+	{
+		return false;
+	}
+
+	// the full ragdoll takes over from any hit reaction
+	Release(Character);
+
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	// nobody sees ragdolls on a dedicated server
+	if (Character->GetNetMode() != NM_DedicatedServer && MakeRoom(DeathRagdolls, CVarCombatRagdollMaxActive.GetValueOnGameThread(), Character, &UCombatRagdollSubsystem::FreezeRagdoll))
+	{
+		// enable full ragdoll physics
+		Mesh->SetSimulatePhysics(true);
+
+		DeathRagdolls.Add({ Character, GetWorld()->GetTimeSeconds() });
+		UpdateStats();
+
+		return true;
+	}
+
+	INC_DWORD_STAT(STAT_RagdollsDenied);
+
+	// stay animated and play the death animation instead
+	Mesh->SetPhysicsBlendWeight(0.0f);
+
+	if (FallbackMontage)
+	{
+		if (UAnimInstance* AnimInstance = Mesh->GetAnimInstance())
+		{
+			AnimInstance->Montage_Play(FallbackMontage);
+		}
+	}
+
+	UpdateStats();
+
+	return false;
+}
+
+bool UCombatRagdollSubsystem::StartHitReact(ACharacter* Character, FName PelvisBoneName)
+{
+	if (!Character)
+	{
+		return false;
+	}
+
+	const double Now = GetWorld()->GetTimeSeconds();
+
+	// already reacting? Keep the slot and restart its timeout
+	if (FRagdollSlot* Slot = HitReacts.FindByPredicate([Character](const FRagdollSlot& Existing) { return Existing.Character == Character; }))
+	{
+		Slot->StartTime = Now;
+	}
+	else
+	{
+		// nobody sees hit reactions on a dedicated server
+		if (Character->GetNetMode() == NM_DedicatedServer || !MakeRoom(HitReacts, CVarCombatRagdollMaxHitReacts.GetValueOnGameThread(), Character, &UCombatRagdollSubsystem::StopHitReact))
+		{
+			INC_DWORD_STAT(STAT_HitReactsDenied);
+			return false;
+		}
+
+		HitReacts.Add({ Character, Now });
+		UpdateStats();
+	}
+
+	// enable partial ragdoll physics, but keep the pelvis vertical
+	Character->GetMesh()->SetPhysicsBlendWeight(CombatRagdoll::HitReactBlendWeight);
+	Character->GetMesh()->SetBodySimulatePhysics(PelvisBoneName, false);
+
+	return true;
+}
+
+void UCombatRagdollSubsystem::EndHitReact(ACharacter* Character)
+{
+	if (!Character)
+	{
+		return;
+	}
+
+	HitReacts.RemoveAllSwap([Character](const FRagdollSlot& Slot) { return Slot.Character == Character; });
+
+	StopHitReact(Character);
+	UpdateStats();
+}
+
+void UCombatRagdollSubsystem::Release(ACharacter* Character)
+{
+	const auto IsCharacter = [Character](const FRagdollSlot& Slot) { return Slot.Character == Character; };
+
+	DeathRagdolls.RemoveAllSwap(IsCharacter);
+	HitReacts.RemoveAllSwap(IsCharacter);
+
+	UpdateStats();
+}
+
+void UCombatRagdollSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	const double Now = GetWorld()->GetTimeSeconds();
+	const double FreezeTime = CVarCombatRagdollFreezeTime.GetValueOnGameThread();
+	const double SleepSpeedSquared = FMath::Square(CVarCombatRagdollSleepSpeed.GetValueOnGameThread());
+	const double HitReactTimeout = CVarCombatRagdollHitReactTimeout.GetValueOnGameThread();
+
+	// put settled or old ragdolls to sleep, freeing their slot
+	DeathRagdolls.RemoveAllSwap([&](const FRagdollSlot& Slot)
+	{
+		ACharacter* Character = Slot.Character.Get();
+		if (!Character)
+		{
+			return true;
+		}
+
+		const double Age = Now - Slot.StartTime;
+		const bool bSettled = Age >= CombatRagdoll::MinSettleTime && Character->GetMesh()->GetPhysicsLinearVelocity().SizeSquared() < SleepSpeedSquared;
+
+		if (bSettled || Age >= FreezeTime)
+		{
+			FreezeRagdoll(Character);
+			return true;
+		}
+
+		return false;
+	});
+
+	// blend out hit reactions that never landed
+	HitReacts.RemoveAllSwap([&](const FRagdollSlot& Slot)
+	{
+		ACharacter* Character = Slot.Character.Get();
+		if (!Character)
+		{
+			return true;
+		}
+
+		if (Now - Slot.StartTime >= HitReactTimeout)
+		{
+			StopHitReact(Character);
+			return true;
+		}
+
+		return false;
+	});
+
+	UpdateStats();
+}
+
+float UCombatRagdollSubsystem::GetPriorityScore(const ACharacter* Character, double StartTime) const
+{
+	// ragdolls far from every player matter less
+	float Distance = UE_BIG_NUMBER;
+
+	if (UPlayerTargetSubsystem* PlayerTargets = GetWorld()->GetSubsystem<UPlayerTargetSubsystem>())
+	{
+		if (const APawn* Player = PlayerTargets->FindNearestPlayer(Character->GetActorLocation()))
+		{
+			Distance = FVector::Distance(Character->GetActorLocation(), Player->GetActorLocation());
+		}
+	}
+
+	// and so do older ones
+	const float Age = GetWorld()->GetTimeSeconds() - StartTime;
+
+	return Distance + Age * CombatRagdoll::AgeScorePerSecond;
+}
+
+bool UCombatRagdollSubsystem::MakeRoom(TArray<FRagdollSlot>& Slots, int32 Budget, const ACharacter* Character, TFunctionRef<void(ACharacter*)> Evict)
+{
+	Slots.RemoveAllSwap([](const FRagdollSlot& Slot) { return !Slot.Character.IsValid(); });
+
+	if (Slots.Num() < Budget)
+	{
+		return true;
+	}
+
+	if (Slots.Num() == 0)
+	{
+		return false;
+	}
+
+	// find the least important slot
+	int32 WorstIndex = INDEX_NONE;
+	float WorstScore = -1.0f;
+
+	for (int32 SlotIndex = 0; SlotIndex < Slots.Num(); ++SlotIndex)
+	{
+		const float Score = GetPriorityScore(Slots[SlotIndex].Character.Get(), Slots[SlotIndex].StartTime);
+		if (Score > WorstScore)
+		{
+			WorstIndex = SlotIndex;
+			WorstScore = Score;
+		}
+	}
+
+	// only evict it for a more important request
+	if (WorstScore <= GetPriorityScore(Character, GetWorld()->GetTimeSeconds()))
+	{
+		return false;
+	}
+
+	Evict(Slots[WorstIndex].Character.Get());
+	Slots.RemoveAtSwap(WorstIndex);
+
+	return true;
+}
+
+void UCombatRagdollSubsystem::FreezeRagdoll(ACharacter* Character)
+{
+	USkeletalMeshComponent* Mesh = Character->GetMesh();
+
+	if (Mesh->IsSimulatingPhysics())
+	{
+		Mesh->PutAllRigidBodiesToSleep();
+	}
+}
+
+void UCombatRagdollSubsystem::StopHitReact(ACharacter* Character)
+{
+	Character->GetMesh()->SetPhysicsBlendWeight(0.0f);
+}
+
+void UCombatRagdollSubsystem::UpdateStats() const
+{
+	SET_DWORD_STAT(STAT_ActiveRagdolls, DeathRagdolls.Num());
+	SET_DWORD_STAT(STAT_ActiveHitReacts, HitReacts.Num());
+}
@@ -0,0 +1,79 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatRagdollSubsystem.generated.h"
+
+class ACharacter;
+class UAnimMontage;
+
+/**
+ *  Caps the number of simulated death ragdolls and partial ragdoll hit reactions.
+ *  Requests are prioritized by distance to the nearest player and recency. When a budget is full,
+ *  a request only gets a slot by evicting a lower priority one; otherwise deaths play a baked death montage
+ *  and hit reactions are skipped. Death ragdolls are put to sleep once they settle, or after a time limit,
+ *  which frees their slot.
+ */
+UCLASS()
+class UCombatRagdollSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** A character using a ragdoll slot */
+	struct FRagdollSlot
+	{
+		/** Ragdolling character */
+		TWeakObjectPtr<ACharacter> Character;
+
+		/** World time the slot was granted */
+		double StartTime = 0.0;
+	};
+
+	/** Characters simulating a full death ragdoll */
+	TArray<FRagdollSlot> DeathRagdolls;
+
+	/** Characters blending a partial ragdoll hit reaction */
+	TArray<FRagdollSlot> HitReacts;
+
+public:
+
+	/** Ragdolls the character's mesh if the budget allows. Otherwise plays the fallback death montage. Returns true if ragdolling */
+	bool StartDeathRagdoll(ACharacter* Character, UAnimMontage* FallbackMontage);
+
+	/** Blends in a partial ragdoll, keeping the pelvis animated, if the budget allows. Returns true if the hit reaction plays */
+	bool StartHitReact(ACharacter* Character, FName PelvisBoneName);
+
+	/** Blends out the character's hit reaction, if any */
+	void EndHitReact(ACharacter* Character);
+
+	/** Frees any slot used by the character without touching its mesh, e.g. when it's reset for reuse */
+	void Release(ACharacter* Character);
+
+	/** Puts settled ragdolls to sleep and expires hit reactions */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tickable */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Only game worlds have ragdolls */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Returns how much a character's ragdoll matters. Lower is more important */
+	float GetPriorityScore(const ACharacter* Character, double StartTime) const;
+
+	/** Makes room in a budget for a new slot, evicting the least important slot if it matters less than the new one. Returns false if there's no room */
+	bool MakeRoom(TArray<FRagdollSlot>& Slots, int32 Budget, const ACharacter* Character, TFunctionRef<void(ACharacter*)> Evict);
+
+	/** Puts a death ragdoll to sleep */
+	static void FreezeRagdoll(ACharacter* Character);
+
+	/** Blends out a hit reaction */
+	static void StopHitReact(ACharacter* Character);
+
+	/** Updates the ragdoll count stats */
+	void UpdateStats() const;
+};
@@ -0,0 +1,122 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatSpawnQueueSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Spawn Queue Process"), STAT_SpawnQueueProcess, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Spawns"), STAT_QueuedSpawns, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Spawn Queue Depth"), STAT_SpawnQueueDepth, STATGROUP_ThirdPersonMP);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Spawn Queue Max Latency (ms)"), STAT_SpawnQueueMaxLatency, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<bool> CVarCombatSpawnQueue(
+	TEXT("Combat.SpawnQueue"),
+	true,
+	TEXT("Spread enemy spawns and spawner activations across frames. When false, they run as soon as they're requested."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCombatSpawnQueueMaxSpawnsPerFrame(
+	TEXT("Combat.SpawnQueue.MaxSpawnsPerFrame"),
+	2,
+	TEXT("Maximum number of enemies spawned from the spawn queue per frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCombatSpawnQueueBudgetMs(
+	TEXT("Combat.SpawnQueue.BudgetMs"),
+	3.0f,
+	TEXT("Milliseconds per frame the spawn queue may spend spawning. At least one request is always processed."),
+	ECVF_Default);
+
+namespace CombatSpawnQueue
+{
+	/** Orders the request heap by priority, then queue order */
+	struct FRequestPredicate
+	{
+		bool operator()(const FCombatSpawnRequest& A, const FCombatSpawnRequest& B) const
+		{
+			return A.Priority != B.Priority ? A.Priority > B.Priority : A.Sequence < B.Sequence;
+		}
+	};
+}
+
+bool UCombatSpawnQueueSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatSpawnQueueSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatSpawnQueueSubsystem, STATGROUP_Tickables);
+}
+
+void UCombatSpawnQueueSubsystem::Enqueue(FCombatSpawnRequest&& Request)
+{
+	// run the request right away
+	if (!CVarCombatSpawnQueue.GetValueOnGameThread())
+	{
+		INC_DWORD_STAT_BY(STAT_QueuedSpawns, Request.SpawnCount);
+		Request.Execute.ExecuteIfBound();
+		return;
+	}
+
+	Request.QueueTime = FPlatformTime::Seconds();
+	Request.Sequence = NextSequence++;
+
+	Requests.HeapPush(MoveTemp(Request), CombatSpawnQueue::FRequestPredicate());
+
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, Requests.Num());
+}
+
+void UCombatSpawnQueueSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (Requests.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SpawnQueueProcess);
+
+	const double StartTime = FPlatformTime::Seconds();
+	const double BudgetSeconds = CVarCombatSpawnQueueBudgetMs.GetValueOnGameThread() * 0.001;
+	const int32 MaxSpawns = CVarCombatSpawnQueueMaxSpawnsPerFrame.GetValueOnGameThread();
+
+	int32 Spawned = 0;
+	int32 Processed = 0;
+	double MaxLatency = 0.0;
+
+	while (Requests.Num() > 0)
+	{
+		// stop once either budget runs out, but always process at least one request
+		if (Processed > 0)
+		{
+			const bool bOverSpawnBudget = Spawned + Requests.HeapTop().SpawnCount > MaxSpawns;
+			const bool bOverTimeBudget = FPlatformTime::Seconds() - StartTime >= BudgetSeconds;
+
+			if (bOverSpawnBudget || bOverTimeBudget)
+			{
+				break;
+			}
+		}
+
+		FCombatSpawnRequest Request;
+		Requests.HeapPop(Request, CombatSpawnQueue::FRequestPredicate(), EAllowShrinking::No);
+
+		++Processed;
+		Spawned += Request.SpawnCount;
+		MaxLatency = FMath::Max(MaxLatency, FPlatformTime::Seconds() - Request.QueueTime);
+
+		INC_DWORD_STAT_BY(STAT_QueuedSpawns, Request.SpawnCount);
+
+		// activations may queue further spawns, which can still be processed this frame
+		Request.Execute.ExecuteIfBound();
+	}
+
+	SET_DWORD_STAT(STAT_SpawnQueueDepth, Requests.Num());
+	SET_FLOAT_STAT(STAT_SpawnQueueMaxLatency, MaxLatency * 1000.0);
+
+	UE_LOG(LogThirdPersonMP, Verbose, TEXT("Spawn queue processed %d requests (%d spawns) in %.2f ms, %d left, max latency %.1f ms"),
+		Processed, Spawned, (FPlatformTime::Seconds() - StartTime) * 1000.0, Requests.Num(), MaxLatency * 1000.0);
+}
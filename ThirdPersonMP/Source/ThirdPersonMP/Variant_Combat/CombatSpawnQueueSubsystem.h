@@ -0,0 +1,75 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "CombatSpawnQueueSubsystem.generated.h"
+
+/**
+ *  Order in which queued spawns are processed
+ */
+UENUM(BlueprintType)
+enum class ECombatSpawnPriority : uint8
+{
+	Low,
+	Normal,
+	High
+};
+
+/**
+ *  A spawn or activation waiting in the spawn queue
+ */
+struct FCombatSpawnRequest
+{
+	/** Performs the spawn */
+	FSimpleDelegate Execute;
+
+	/** Higher priority requests are processed first */
+	ECombatSpawnPriority Priority = ECombatSpawnPriority::Normal;
+
+	/** Number of actors the request spawns, counted against the per-frame spawn budget. Activations that only queue further spawns use 0 */
+	int32 SpawnCount = 1;
+
+	/** Time the request was queued, for latency tracking */
+	double QueueTime = 0.0;
+
+	/** Keeps requests of the same priority in queue order */
+	uint64 Sequence = 0;
+};
+
+/**
+ *  Spreads spawns from all enemy spawners and activation volumes across frames.
+ *  Queued requests are processed by priority, then in queue order, until the per-frame spawn count
+ *  or time budget runs out. At least one request is processed each frame so the queue always drains.
+ */
+UCLASS()
+class UCombatSpawnQueueSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Pending requests, as a heap */
+	TArray<FCombatSpawnRequest> Requests;
+
+	/** Sequence number of the next request */
+	uint64 NextSequence = 0;
+
+public:
+
+	/** Queues a request. It runs on a later tick, or right away if the spawn queue is disabled */
+	void Enqueue(FCombatSpawnRequest&& Request);
+
+	/** Returns the number of pending requests */
+	int32 GetQueueDepth() const { return Requests.Num(); }
+
+	/** Processes queued requests within the frame budget */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tickable */
+	virtual TStatId GetStatId() const override;
+
+protected:
+
+	/** Only game worlds spawn enemies */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+};
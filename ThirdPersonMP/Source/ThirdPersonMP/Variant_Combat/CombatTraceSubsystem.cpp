@@ -0,0 +1,146 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatTraceSubsystem.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Melee Sweeps"), STAT_MeleeSweeps, STATGROUP_ThirdPersonMP);
+DECLARE_CYCLE_STAT(TEXT("Melee Sweep Submit"), STAT_MeleeSweepSubmit, STATGROUP_ThirdPersonMP);
+DECLARE_CYCLE_STAT(TEXT("Melee Sweep Resolve"), STAT_MeleeSweepResolve, STATGROUP_ThirdPersonMP);
+DECLARE_CYCLE_STAT(TEXT("Melee Sweep (Sync)"), STAT_MeleeSweepSync, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<bool> CVarCombatAsyncMeleeSweeps(
+	TEXT("Combat.AsyncMeleeSweeps"),
+	true,
+	TEXT("Batch melee attack sweeps into async traces resolved the next frame. When false, sweeps run synchronously on the game thread, for comparing the Melee Sweep stats."),
+	ECVF_Default);
+
+void UCombatTraceSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	SweepCompletedDelegate.BindUObject(this, &UCombatTraceSubsystem::OnSweepCompleted);
+}
+
+bool UCombatTraceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatTraceSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatTraceSubsystem, STATGROUP_Tickables);
+}
+
+void UCombatTraceSubsystem::QueueSweep(FCombatSweepRequest&& Request)
+{
+	INC_DWORD_STAT(STAT_MeleeSweeps);
+
+	// batch the sweep with the rest of this frame's
+	if (CVarCombatAsyncMeleeSweeps.GetValueOnGameThread())
+	{
+		QueuedSweeps.Add(MoveTemp(Request));
+		return;
+	}
+
+	// sweep right away
+	SCOPE_CYCLE_COUNTER(STAT_MeleeSweepSync);
+
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatMeleeSweep));
+	QueryParams.AddIgnoredActor(Request.Attacker.Get());
+
+	TArray<FHitResult> Hits;
+	GetWorld()->SweepMultiByObjectType(Hits, Request.Start, Request.End, FQuat::Identity, Request.ObjectParams, FCollisionShape::MakeSphere(Request.Radius), QueryParams);
+
+	ResolveSweep(Request, Hits);
+}
+
+void UCombatTraceSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// forget the swings of attackers that are gone
+	for (TMap<TObjectKey<AActor>, FSwingHits>::TIterator It = SwingHits.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().ResolveObjectPtr())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	if (QueuedSweeps.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MeleeSweepSubmit);
+
+	UWorld* World = GetWorld();
+
+	for (FCombatSweepRequest& Request : QueuedSweeps)
+	{
+		// the attacker may have been destroyed since it queued the sweep
+		if (!Request.Attacker.IsValid())
+		{
+			continue;
+		}
+
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(CombatMeleeSweep));
+		QueryParams.AddIgnoredActor(Request.Attacker.Get());
+
+		const uint32 SweepId = NextSweepId++;
+		World->AsyncSweepByObjectType(EAsyncTraceType::Multi, Request.Start, Request.End, FQuat::Identity, Request.ObjectParams, FCollisionShape::MakeSphere(Request.Radius), QueryParams, &SweepCompletedDelegate, SweepId);
+
+		InFlightSweeps.Add(SweepId, MoveTemp(Request));
+	}
+
+	QueuedSweeps.Reset();
+}
+
+void UCombatTraceSubsystem::OnSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum)
+{
+	SCOPE_CYCLE_COUNTER(STAT_MeleeSweepResolve);
+
+	FCombatSweepRequest Request;
+	if (InFlightSweeps.RemoveAndCopyValue(TraceDatum.UserData, Request))
+	{
+		ResolveSweep(Request, TraceDatum.OutHits);
+	}
+}
+
+void UCombatTraceSubsystem::ResolveSweep(FCombatSweepRequest& Request, TArray<FHitResult>& Hits)
+{
+	AActor* Attacker = Request.Attacker.Get();
+	if (!Attacker)
+	{
+		return;
+	}
+
+	// a new swing resets the actors already hit
+	FSwingHits& Swing = SwingHits.FindOrAdd(Attacker);
+	if (Swing.SwingId != Request.SwingId)
+	{
+		Swing.SwingId = Request.SwingId;
+		Swing.HitActors.Reset();
+	}
+
+	// only keep the first hit on each actor for this swing
+	Hits.RemoveAll([&Swing](const FHitResult& Hit)
+	{
+		AActor* HitActor = Hit.GetActor();
+		if (!HitActor || Swing.HitActors.Contains(HitActor))
+		{
+			return true;
+		}
+
+		Swing.HitActors.Add(HitActor);
+		return false;
+	});
+
+	if (Hits.Num() > 0)
+	{
+		Request.OnResolved.ExecuteIfBound(Hits);
+	}
+}
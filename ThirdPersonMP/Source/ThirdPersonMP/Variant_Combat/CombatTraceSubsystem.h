@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Engine/EngineTypes.h"
+#include "WorldCollision.h"
+#include "UObject/ObjectKey.h"
+#include "CombatTraceSubsystem.generated.h"
+
+/** Called with the deduplicated hits of a melee sweep */
+DECLARE_DELEGATE_OneParam(FOnCombatSweepResolved, const TArray<FHitResult>& /*Hits*/);
+
+/**
+ *  A melee attack sphere sweep waiting to be traced
+ */
+struct FCombatSweepRequest
+{
+	/** Actor performing the attack. Ignored by the sweep */
+	TWeakObjectPtr<AActor> Attacker;
+
+	/** Identifies the attacker's swing. Each actor is only reported once per swing */
+	uint32 SwingId = 0;
+
+	/** Sweep start location */
+	FVector Start = FVector::ZeroVector;
+
+	/** Sweep end location */
+	FVector End = FVector::ZeroVector;
+
+	/** Sweep sphere radius */
+	float Radius = 0.0f;
+
+	/** Object types the sweep hits */
+	FCollisionObjectQueryParams ObjectParams;
+
+	/** Called once the sweep is resolved */
+	FOnCombatSweepResolved OnResolved;
+};
+
+/**
+ *  Batches melee attack sweeps from all attackers.
+ *  Sweeps queued during a frame are submitted together as async traces at the end of the frame,
+ *  and resolved when their results come back at the start of the next frame.
+ *  Hits are deduplicated per actor within each attacker's swing.
+ */
+UCLASS()
+class UCombatTraceSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** Actors already hit by an attacker's current swing */
+	struct FSwingHits
+	{
+		uint32 SwingId = 0;
+		TArray<TWeakObjectPtr<AActor>> HitActors;
+	};
+
+	/** Sweeps queued this frame */
+	TArray<FCombatSweepRequest> QueuedSweeps;
+
+	/** Sweeps submitted to the async trace system, keyed by trace user data */
+	TMap<uint32, FCombatSweepRequest> InFlightSweeps;
+
+	/** Actors hit per attacker swing */
+	TMap<TObjectKey<AActor>, FSwingHits> SwingHits;
+
+	/** Async trace completion delegate */
+	FTraceDelegate SweepCompletedDelegate;
+
+	/** Next trace user data to hand out */
+	uint32 NextSweepId = 1;
+
+public:
+
+	/** Initialization */
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+
+	/** Submits the sweeps queued this frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Queues a melee sweep. The request's delegate is called with its hits once resolved, usually next frame */
+	void QueueSweep(FCombatSweepRequest&& Request);
+
+protected:
+
+	/** Only game worlds run attacks */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Called by the async trace system with a sweep's results */
+	void OnSweepCompleted(const FTraceHandle& TraceHandle, FTraceDatum& TraceDatum);
+
+	/** Filters the hits and passes them to the request's delegate */
+	void ResolveSweep(FCombatSweepRequest& Request, TArray<FHitResult>& Hits);
+};
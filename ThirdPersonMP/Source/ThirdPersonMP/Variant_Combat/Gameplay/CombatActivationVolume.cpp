@@ -34,16 +34,35 @@ void ACombatActivationVolume::OnOverlap(UPrimitiveComponent* OverlappedComponent
 		// is the Character controlled by a player
 		if (PlayerCharacter->IsPlayerControlled())
 		{
+			UCombatSpawnQueueSubsystem* SpawnQueue = GetWorld()->GetSubsystem<UCombatSpawnQueueSubsystem>();
+
 			// process the actors to activate list
 			for (AActor* CurrentActor : ActorsToActivate)
 			{
-				// is the referenced actor activatable?
-				if(ICombatActivatable* Activatable = Cast<ICombatActivatable>(CurrentActor))
+				// no queue in this world, activate right away
+				if (!SpawnQueue)
 				{
-					Activatable->ActivateInteraction(PlayerCharacter);
+					ActivateActor(CurrentActor, PlayerCharacter);
+					continue;
 				}
+
+				// spread the activations, and the spawns they trigger, across frames
+				FCombatSpawnRequest Request;
+				Request.Execute.BindUObject(this, &ACombatActivationVolume::ActivateActor, TWeakObjectPtr<AActor>(CurrentActor), TWeakObjectPtr<AActor>(PlayerCharacter));
+				Request.Priority = ActivationPriority;
+				Request.SpawnCount = 0;
+				SpawnQueue->Enqueue(MoveTemp(Request));
 			}
 		}
 	}
 
+}
+
+void ACombatActivationVolume::ActivateActor(TWeakObjectPtr<AActor> ActorToActivate, TWeakObjectPtr<AActor> ActivationInstigator)
+{
+	// is the referenced actor activatable?
+	if (ICombatActivatable* Activatable = Cast<ICombatActivatable>(ActorToActivate.Get()))
+	{
+		Activatable->ActivateInteraction(ActivationInstigator.Get());
+	}
 }
\ No newline at end of file
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameFramework/Actor.h"
+#include "CombatSpawnQueueSubsystem.h"
 #include "CombatActivationVolume.generated.h"
 
 class UBoxComponent;
@@ -26,6 +27,10 @@ protected:
 	UPROPERTY(EditAnywhere, Category="Activation Volume")
 	TArray<AActor*> ActorsToActivate;
 
+	/** Priority of the activations in the spawn queue. Spawners activated by this volume queue their spawns at their own priority */
+	UPROPERTY(EditAnywhere, Category="Activation Volume")
+	ECombatSpawnPriority ActivationPriority = ECombatSpawnPriority::High;
+
 public:	
 	
 	/** Constructor */
@@ -37,4 +42,7 @@ protected:
 	UFUNCTION()
 	void OnOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
 
+	/** Activates an actor from the list, once the spawn queue gets to it */
+	void ActivateActor(TWeakObjectPtr<AActor> ActorToActivate, TWeakObjectPtr<AActor> ActivationInstigator);
+
 };
@@ -0,0 +1,104 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatDamageZoneComponent.h"
+#include "CombatDamageable.h"
+#include "Engine/World.h"
+#include "TimerManager.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Damage Zone Hits"), STAT_DamageZoneHits, STATGROUP_ThirdPersonMP);
+
+UCombatDamageZoneComponent::UCombatDamageZoneComponent()
+{
+	PrimaryComponentTick.bCanEverTick = false;
+
+	// only overlap, never block
+	SetCollisionProfileName(FName("OverlapAllDynamic"));
+	SetGenerateOverlapEvents(true);
+
+	// track the actors entering and leaving the zone
+	OnComponentBeginOverlap.AddDynamic(this, &UCombatDamageZoneComponent::OnZoneBeginOverlap);
+	OnComponentEndOverlap.AddDynamic(this, &UCombatDamageZoneComponent::OnZoneEndOverlap);
+}
+
+void UCombatDamageZoneComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	// clear the damage timer
+	GetWorld()->GetTimerManager().ClearTimer(DamageTimer);
+}
+
+void UCombatDamageZoneComponent::OnZoneBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+{
+	// ignore actors that can't be damaged, and actors already inside through another component
+	if (!Cast<ICombatDamageable>(OtherActor) || Occupants.Contains(OtherActor))
+	{
+		return;
+	}
+
+	Occupants.Add(OtherActor);
+
+	if (bDamageOnEnter)
+	{
+		DamageOccupant(OtherActor);
+	}
+
+	// start damaging at a fixed rate
+	if (!DamageTimer.IsValid())
+	{
+		GetWorld()->GetTimerManager().SetTimer(DamageTimer, this, &UCombatDamageZoneComponent::ApplyZoneDamage, DamageInterval, true);
+	}
+}
+
+void UCombatDamageZoneComponent::OnZoneEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+{
+	// is the actor still inside through another component?
+	if (IsOverlappingActor(OtherActor))
+	{
+		return;
+	}
+
+	Occupants.RemoveSingleSwap(OtherActor);
+
+	// stop the timer while the zone is empty
+	if (Occupants.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(DamageTimer);
+	}
+}
+
+void UCombatDamageZoneComponent::ApplyZoneDamage()
+{
+	// drop occupants destroyed while inside
+	Occupants.RemoveAllSwap([](const TWeakObjectPtr<AActor>& Occupant) { return !Occupant.IsValid(); });
+
+	if (Occupants.Num() == 0)
+	{
+		GetWorld()->GetTimerManager().ClearTimer(DamageTimer);
+		return;
+	}
+
+	// damage may destroy or move occupants, so work on a copy
+	const TArray<TWeakObjectPtr<AActor>> CurrentOccupants = Occupants;
+
+	for (const TWeakObjectPtr<AActor>& Occupant : CurrentOccupants)
+	{
+		if (AActor* OccupantActor = Occupant.Get())
+		{
+			DamageOccupant(OccupantActor);
+		}
+	}
+}
+
+void UCombatDamageZoneComponent::DamageOccupant(AActor* Occupant)
+{
+	if (ICombatDamageable* Damageable = Cast<ICombatDamageable>(Occupant))
+	{
+		INC_DWORD_STAT(STAT_DamageZoneHits);
+
+		// damage the actor
+		Damageable->ApplyDamage(Damage, GetOwner(), Occupant->GetActorLocation(), FVector::ZeroVector);
+	}
+}
@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/BoxComponent.h"
+#include "CombatDamageZoneComponent.generated.h"
+
+/**
+ *  A box volume that damages the ICombatDamageable actors inside it over time.
+ *  Occupants are tracked through overlap events, and damaged together once per interval
+ *  so the damage rate doesn't depend on frame rate or collision events.
+ *  Can be added to any actor to make it a hazard.
+ */
+UCLASS(ClassGroup=(Combat), meta=(BlueprintSpawnableComponent))
+class UCombatDamageZoneComponent : public UBoxComponent
+{
+	GENERATED_BODY()
+
+public:
+
+	/** Amount of damage dealt to each occupant per interval */
+	UPROPERTY(EditAnywhere, Category="Damage Zone", meta = (ClampMin = 0))
+	float Damage = 1.0f;
+
+	/** Time between damage applications */
+	UPROPERTY(EditAnywhere, Category="Damage Zone", meta = (ClampMin = 0.05, ClampMax = 10, Units = "s"))
+	float DamageInterval = 0.5f;
+
+	/** If true, actors are also damaged as soon as they enter the zone */
+	UPROPERTY(EditAnywhere, Category="Damage Zone")
+	bool bDamageOnEnter = true;
+
+protected:
+
+	/** Damageable actors currently inside the zone */
+	TArray<TWeakObjectPtr<AActor>> Occupants;
+
+	/** Damage interval timer. Only runs while the zone is occupied */
+	FTimerHandle DamageTimer;
+
+public:
+
+	/** Constructor */
+	UCombatDamageZoneComponent();
+
+protected:
+
+	/** Clears the damage timer */
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	/** Starts tracking damageable actors entering the zone */
+	UFUNCTION()
+	void OnZoneBeginOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+
+	/** Stops tracking actors leaving the zone */
+	UFUNCTION()
+	void OnZoneEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+
+	/** Damages every occupant */
+	void ApplyZoneDamage();
+
+	/** Damages a single occupant */
+	void DamageOccupant(AActor* Occupant);
+};
@@ -5,6 +5,7 @@
 #include "Components/StaticMeshComponent.h"
 #include "TimerManager.h"
 #include "Engine/World.h"
+#include "HealthComponent.h"
 
 ACombatDamageableBox::ACombatDamageableBox()
 {
@@ -21,6 +22,24 @@ ACombatDamageableBox::ACombatDamageableBox()
 
 	// disable navigation relevance so boxes don't affect NavMesh generation
 	Mesh->bNavigationRelevant = false;
+
+	// create the health component with the amount of HP this box starts with
+	HealthComponent = CreateDefaultSubobject<UHealthComponent>(TEXT("HealthComponent"));
+	HealthComponent->MaxHealth = 3.0f;
+}
+
+void ACombatDamageableBox::PostLoad()
+{
+	Super::PostLoad();
+
+#if WITH_EDITORONLY_DATA
+	// move the starting HP saved before health moved to the health component
+	if (CurrentHP_DEPRECATED >= 0.0f)
+	{
+		HealthComponent->MaxHealth = CurrentHP_DEPRECATED;
+		CurrentHP_DEPRECATED = -1.0f;
+	}
+#endif
 }
 
 void ACombatDamageableBox::RemoveFromLevel()
@@ -40,13 +59,13 @@ void ACombatDamageableBox::EndPlay(EEndPlayReason::Type EndPlayReason)
 void ACombatDamageableBox::ApplyDamage(float Damage, AActor* DamageCauser, const FVector& DamageLocation, const FVector& DamageImpulse)
 {
 	// only process damage if we still have HP
-	if (CurrentHP > 0.0f)
+	if (!HealthComponent->IsDead())
 	{
 		// apply the damage
-		CurrentHP -= Damage;
+		HealthComponent->ApplyDamage(Damage);
 
 		// are we dead?
-		if (CurrentHP <= 0.0f)
+		if (HealthComponent->IsDead())
 		{
 			HandleDeath();
 		}
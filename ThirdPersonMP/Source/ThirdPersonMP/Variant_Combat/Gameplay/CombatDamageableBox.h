@@ -7,6 +7,8 @@
 #include "CombatDamageable.h"
 #include "CombatDamageableBox.generated.h"
 
+class UHealthComponent;
+
 /**
  *  A simple physics box that reacts to damage through the ICombatDamageable interface
  */
@@ -19,6 +21,10 @@ class ACombatDamageableBox : public AActor, public ICombatDamageable
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* Mesh;
 
+	/** Health component, holds the box's HP */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Components", meta = (AllowPrivateAccess = "true"))
+	UHealthComponent* HealthComponent;
+
 public:	
 
 	/** Constructor */
@@ -26,9 +32,14 @@ public:
 
 protected:
 
-	/** Amount of HP this box starts with. */
-	UPROPERTY(EditAnywhere, Category="Damage")
-	float CurrentHP = 3.0f;
+#if WITH_EDITORONLY_DATA
+	/** Starting HP saved before it moved to the health component, copied to it on load. Negative when unset */
+	UPROPERTY()
+	float CurrentHP_DEPRECATED = -1.0f;
+#endif
+
+	/** Migrates health data saved before the health component */
+	virtual void PostLoad() override;
 
 	/** Time to wait before we remove this box from the level. */
 	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 0, ClampMax = 10, Units = "s"))
@@ -2,8 +2,9 @@
 
 
 #include "CombatLavaFloor.h"
-#include "CombatDamageable.h"
+#include "CombatDamageZoneComponent.h"
 #include "Components/StaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
 
 ACombatLavaFloor::ACombatLavaFloor()
 {
@@ -12,16 +13,32 @@ ACombatLavaFloor::ACombatLavaFloor()
 	// create the mesh
 	RootComponent = Mesh = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("Mesh"));
 
-	// bind the hit handler
-	Mesh->OnComponentHit.AddDynamic(this, &ACombatLavaFloor::OnFloorHit);
+	// create the damage zone. It's sized in world space so it ignores the mesh scale
+	DamageZone = CreateDefaultSubobject<UCombatDamageZoneComponent>(TEXT("DamageZone"));
+	DamageZone->SetupAttachment(Mesh);
+	DamageZone->SetUsingAbsoluteScale(true);
+
+	// lava kills on contact
+	DamageZone->Damage = 10000.0f;
+	DamageZone->bDamageOnEnter = true;
 }
 
-void ACombatLavaFloor::OnFloorHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+void ACombatLavaFloor::OnConstruction(const FTransform& Transform)
 {
-	// check if the hit actor is damageable by casting to the interface
-	if (ICombatDamageable* Damageable = Cast<ICombatDamageable>(OtherActor))
+	Super::OnConstruction(Transform);
+
+	// cover the top of the floor mesh, in the mesh's local space so the zone follows the floor's rotation
+	const UStaticMesh* StaticMesh = Mesh->GetStaticMesh();
+	const FBox LocalBounds = StaticMesh ? StaticMesh->GetBounds().GetBox() : FBox(ForceInit);
+
+	if (LocalBounds.IsValid)
 	{
-		// damage the actor
-		Damageable->ApplyDamage(Damage, this, Hit.ImpactPoint, FVector::ZeroVector);
+		// the zone ignores the mesh scale, so its extent is scaled here and its height stays in world units
+		const FVector Scale = Mesh->GetRelativeScale3D().GetAbs();
+		const FVector Extent = LocalBounds.GetExtent() * Scale;
+		const float HeightOffset = Scale.Z > UE_SMALL_NUMBER ? DamageZoneHeight * 0.5f / Scale.Z : 0.0f;
+
+		DamageZone->SetBoxExtent(FVector(Extent.X, Extent.Y, DamageZoneHeight * 0.5f));
+		DamageZone->SetRelativeLocationAndRotation(FVector(LocalBounds.GetCenter().X, LocalBounds.GetCenter().Y, LocalBounds.Max.Z + HeightOffset), FQuat::Identity);
 	}
 }
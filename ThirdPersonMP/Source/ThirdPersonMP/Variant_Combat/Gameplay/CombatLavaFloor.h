@@ -7,10 +7,10 @@
 #include "CombatLavaFloor.generated.h"
 
 class UStaticMeshComponent;
-class UPrimitiveComponent;
+class UCombatDamageZoneComponent;
 
 /**
- *  A basic actor that applies damage on contact through the ICombatDamageable interface. 
+ *  A floor that damages the ICombatDamageable actors standing on it through a damage zone covering its top surface.
  */
 UCLASS(abstract)
 class ACombatLavaFloor : public AActor
@@ -21,11 +21,15 @@ class ACombatLavaFloor : public AActor
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
 	UStaticMeshComponent* Mesh;
 
+	/** Damage zone over the floor's surface */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category="Components", meta = (AllowPrivateAccess = "true"))
+	UCombatDamageZoneComponent* DamageZone;
+
 protected:
 
-	/** Amount of damage to deal on contact */
-	UPROPERTY(EditAnywhere, Category="Damage")
-	float Damage = 10000.0f;
+	/** Height of the damage zone above the floor's surface */
+	UPROPERTY(EditAnywhere, Category="Damage", meta = (ClampMin = 1, ClampMax = 200, Units = "cm"))
+	float DamageZoneHeight = 20.0f;
 
 public:	
 
@@ -34,7 +38,6 @@ public:
 
 protected:
 
-	/** Blocking hit handler */
-	UFUNCTION()
-	void OnFloorHit(UPrimitiveComponent* HitComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+	/** Fits the damage zone to the floor mesh */
+	virtual void OnConstruction(const FTransform& Transform) override;
 };
@@ -26,6 +26,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void DoAttackTrace(FName DamageSourceBone) = 0;
 
+	/** Performs an attack's collision check from the given world location. Used when attacks are played from baked timing instead of animation */
+	virtual void DoAttackTraceFromLocation(const FVector& TraceStart) = 0;
+
 	/** Performs a combo attack's check to continue the string. Usually called from a montage's AnimNotify */
 	UFUNCTION(BlueprintCallable, Category="Attacker")
 	virtual void CheckCombo() = 0;
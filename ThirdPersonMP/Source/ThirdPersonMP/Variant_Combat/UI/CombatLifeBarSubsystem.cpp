@@ -0,0 +1,220 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "CombatLifeBarSubsystem.h"
+#include "SCombatLifeBarLayer.h"
+#include "Engine/Engine.h"
+#include "Engine/GameViewportClient.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Camera/PlayerCameraManager.h"
+#include "HAL/IConsoleManager.h"
+#include "ThirdPersonMP.h"
+
+DECLARE_CYCLE_STAT(TEXT("Life Bar Update"), STAT_LifeBarUpdate, STATGROUP_ThirdPersonMP);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Life Bars Drawn"), STAT_LifeBarsDrawn, STATGROUP_ThirdPersonMP);
+
+static TAutoConsoleVariable<float> CVarCombatLifeBarsMaxDistance(
+	TEXT("Combat.LifeBars.MaxDistance"),
+	3000.0f,
+	TEXT("Distance from the camera beyond which life bars are not drawn."),
+	ECVF_Default);
+
+namespace CombatLifeBars
+{
+	/** How recently an actor must have been rendered for its bar to be drawn */
+	static constexpr float RecentlyRenderedTolerance = 0.1f;
+
+	/** Distance up to which bars are drawn at full size */
+	static constexpr float FullScaleDistance = 800.0f;
+
+	/** Smallest size scale for distant bars */
+	static constexpr float MinScale = 0.5f;
+}
+
+bool UCombatLifeBarSubsystem::ShouldCreateSubsystem(UObject* Outer) const
+{
+	return !IsRunningDedicatedServer() && Super::ShouldCreateSubsystem(Outer);
+}
+
+bool UCombatLifeBarSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+TStatId UCombatLifeBarSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UCombatLifeBarSubsystem, STATGROUP_Tickables);
+}
+
+void UCombatLifeBarSubsystem::Deinitialize()
+{
+	// remove the layer from the viewport
+	if (Layer.IsValid())
+	{
+		if (UGameViewportClient* GameViewport = GetWorld()->GetGameViewport())
+		{
+			GameViewport->RemoveViewportWidgetContent(Layer.ToSharedRef());
+		}
+
+		Layer.Reset();
+	}
+
+	Super::Deinitialize();
+}
+
+void UCombatLifeBarSubsystem::RegisterLifeBar(AActor* Actor, const FLinearColor& Color, const FVector& Offset)
+{
+	if (!Actor)
+	{
+		return;
+	}
+
+	// add a bar if the actor doesn't have one yet
+	FLifeBar* LifeBar = FindLifeBar(Actor);
+	if (!LifeBar)
+	{
+		LifeBarIndices.Add(Actor, LifeBars.Num());
+
+		LifeBar = &LifeBars.AddDefaulted_GetRef();
+		LifeBar->Actor = Actor;
+	}
+
+	LifeBar->Color = Color;
+	LifeBar->Offset = Offset;
+}
+
+void UCombatLifeBarSubsystem::UnregisterLifeBar(AActor* Actor)
+{
+	int32 Index = INDEX_NONE;
+	if (!LifeBarIndices.RemoveAndCopyValue(Actor, Index))
+	{
+		return;
+	}
+
+	// keep the array compact, and fix up the index of the bar moved into the gap
+	LifeBars.RemoveAtSwap(Index, EAllowShrinking::No);
+
+	if (LifeBars.IsValidIndex(Index))
+	{
+		LifeBarIndices.Add(LifeBars[Index].Actor.Get(), Index);
+	}
+}
+
+void UCombatLifeBarSubsystem::SetLifePercentage(AActor* Actor, float Percent)
+{
+	if (FLifeBar* LifeBar = FindLifeBar(Actor))
+	{
+		LifeBar->Percent = Percent;
+	}
+}
+
+void UCombatLifeBarSubsystem::SetLifeBarVisible(AActor* Actor, bool bVisible)
+{
+	if (FLifeBar* LifeBar = FindLifeBar(Actor))
+	{
+		LifeBar->bVisible = bVisible;
+	}
+}
+
+UCombatLifeBarSubsystem::FLifeBar* UCombatLifeBarSubsystem::FindLifeBar(const AActor* Actor)
+{
+	const int32* Index = LifeBarIndices.Find(Actor);
+	return Index ? &LifeBars[*Index] : nullptr;
+}
+
+void UCombatLifeBarSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	SCOPE_CYCLE_COUNTER(STAT_LifeBarUpdate);
+
+	UWorld* World = GetWorld();
+
+	// dedicated server worlds can still run in a client or editor process
+	if (World->GetNetMode() == NM_DedicatedServer)
+	{
+		return;
+	}
+
+	// bars are drawn from the point of view of the first local player
+	APlayerController* PlayerController = GEngine->GetFirstLocalPlayerController(World);
+	if (!PlayerController || !PlayerController->PlayerCameraManager)
+	{
+		return;
+	}
+
+	// add the layer to the viewport the first time we have something to draw on
+	if (!Layer.IsValid())
+	{
+		UGameViewportClient* GameViewport = World->GetGameViewport();
+		if (!GameViewport)
+		{
+			return;
+		}
+
+		Layer = SNew(SCombatLifeBarLayer);
+		GameViewport->AddViewportWidgetContent(Layer.ToSharedRef());
+	}
+
+	// drop the bars of actors destroyed without unregistering
+	for (int32 Index = LifeBars.Num() - 1; Index >= 0; --Index)
+	{
+		if (!LifeBars[Index].Actor.IsValid())
+		{
+			LifeBars.RemoveAtSwap(Index, EAllowShrinking::No);
+		}
+	}
+
+	if (LifeBarIndices.Num() != LifeBars.Num())
+	{
+		LifeBarIndices.Reset();
+		for (int32 Index = 0; Index < LifeBars.Num(); ++Index)
+		{
+			LifeBarIndices.Add(LifeBars[Index].Actor.Get(), Index);
+		}
+	}
+
+	const FVector ViewLocation = PlayerController->PlayerCameraManager->GetCameraLocation();
+	const float MaxDistanceSquared = FMath::Square(CVarCombatLifeBarsMaxDistance.GetValueOnGameThread());
+
+	TArray<FCombatLifeBarScreenElement> ScreenBars;
+	ScreenBars.Reserve(LifeBars.Num());
+
+	for (const FLifeBar& LifeBar : LifeBars)
+	{
+		const AActor* Actor = LifeBar.Actor.Get();
+
+		// skip hidden bars and actors that are off screen or occluded
+		if (!LifeBar.bVisible || Actor->IsHidden() || !Actor->WasRecentlyRendered(CombatLifeBars::RecentlyRenderedTolerance))
+		{
+			continue;
+		}
+
+		// skip bars too far away
+		const FVector BarLocation = Actor->GetActorLocation() + LifeBar.Offset;
+		const float DistanceSquared = FVector::DistSquared(ViewLocation, BarLocation);
+
+		if (DistanceSquared > MaxDistanceSquared)
+		{
+			continue;
+		}
+
+		// project the bar to the screen
+		FVector2D ScreenLocation;
+		if (!PlayerController->ProjectWorldLocationToScreen(BarLocation, ScreenLocation, false))
+		{
+			continue;
+		}
+
+		FCombatLifeBarScreenElement& ScreenBar = ScreenBars.AddDefaulted_GetRef();
+		ScreenBar.Position = FVector2f(ScreenLocation);
+		ScreenBar.Scale = FMath::Clamp(CombatLifeBars::FullScaleDistance / FMath::Sqrt(DistanceSquared), CombatLifeBars::MinScale, 1.0f);
+		ScreenBar.Percent = LifeBar.Percent;
+		ScreenBar.Color = LifeBar.Color;
+	}
+
+	SET_DWORD_STAT(STAT_LifeBarsDrawn, ScreenBars.Num());
+
+	Layer->SetBars(MoveTemp(ScreenBars));
+}
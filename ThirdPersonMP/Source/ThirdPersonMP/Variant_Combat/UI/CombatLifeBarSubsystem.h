@@ -0,0 +1,85 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CombatLifeBarSubsystem.generated.h"
+
+class SCombatLifeBarLayer;
+
+/**
+ *  Draws the life bars of every combat character from a single viewport layer.
+ *  Actors register a bar and push their HP percentage to it. Each frame the visible bars are culled by distance
+ *  and by whether their actor was rendered recently, which covers both frustum and occlusion culling,
+ *  then projected to the screen and handed to the layer to be drawn in one pass.
+ *  Not created on dedicated servers.
+ */
+UCLASS()
+class UCombatLifeBarSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+	/** A registered life bar */
+	struct FLifeBar
+	{
+		/** Actor the bar floats over */
+		TWeakObjectPtr<AActor> Actor;
+
+		/** Offset from the actor's location to the bar */
+		FVector Offset = FVector::ZeroVector;
+
+		/** Fill amount, 0-1 */
+		float Percent = 1.0f;
+
+		/** Fill color */
+		FLinearColor Color = FLinearColor::White;
+
+		/** If false, the bar is never drawn */
+		bool bVisible = true;
+	};
+
+	/** Registered life bars, kept compact */
+	TArray<FLifeBar> LifeBars;
+
+	/** Index of each actor's life bar */
+	TMap<TObjectKey<AActor>, int32> LifeBarIndices;
+
+	/** Viewport layer drawing the bars */
+	TSharedPtr<SCombatLifeBarLayer> Layer;
+
+public:
+
+	/** Adds a life bar over an actor, or updates its color and offset if it already has one */
+	void RegisterLifeBar(AActor* Actor, const FLinearColor& Color, const FVector& Offset);
+
+	/** Removes an actor's life bar */
+	void UnregisterLifeBar(AActor* Actor);
+
+	/** Sets the 0-1 fill amount of an actor's life bar */
+	void SetLifePercentage(AActor* Actor, float Percent);
+
+	/** Shows or hides an actor's life bar */
+	void SetLifeBarVisible(AActor* Actor, bool bVisible);
+
+	/** Culls and projects the bars for this frame */
+	virtual void Tick(float DeltaTime) override;
+
+	/** Stat id for the tickable */
+	virtual TStatId GetStatId() const override;
+
+	/** Removes the layer from the viewport */
+	virtual void Deinitialize() override;
+
+protected:
+
+	/** Nothing draws life bars on a dedicated server */
+	virtual bool ShouldCreateSubsystem(UObject* Outer) const override;
+
+	/** Only game worlds have life bars */
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+	/** Returns the life bar of an actor, or nullptr */
+	FLifeBar* FindLifeBar(const AActor* Actor);
+};
@@ -0,0 +1,55 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+
+#include "SCombatLifeBarLayer.h"
+#include "Rendering/DrawElements.h"
+#include "Styling/AppStyle.h"
+
+namespace CombatLifeBarLayer
+{
+	/** Color of the empty part of the bar */
+	static const FLinearColor BackgroundColor(0.0f, 0.0f, 0.0f, 0.6f);
+}
+
+void SCombatLifeBarLayer::Construct(const FArguments& InArgs)
+{
+	BarSize = InArgs._BarSize;
+	BarBrush = FAppStyle::GetBrush("WhiteBrush");
+
+	// never block input to the game or other widgets
+	SetVisibility(EVisibility::HitTestInvisible);
+}
+
+void SCombatLifeBarLayer::SetBars(TArray<FCombatLifeBarScreenElement>&& InBars)
+{
+	Bars = MoveTemp(InBars);
+}
+
+int32 SCombatLifeBarLayer::OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const
+{
+	// positions are in viewport pixels, convert them to our layout units
+	const float InvScale = 1.0f / AllottedGeometry.Scale;
+
+	for (const FCombatLifeBarScreenElement& Bar : Bars)
+	{
+		const FVector2f Size = BarSize * Bar.Scale;
+		const FVector2f TopLeft = Bar.Position * InvScale - Size * 0.5f;
+
+		// background
+		FSlateDrawElement::MakeBox(OutDrawElements, LayerId, AllottedGeometry.ToPaintGeometry(Size, FSlateLayoutTransform(TopLeft)), BarBrush, ESlateDrawEffect::None, CombatLifeBarLayer::BackgroundColor);
+
+		// fill, on the layer above so all the fills batch together
+		const FVector2f FillSize(Size.X * FMath::Clamp(Bar.Percent, 0.0f, 1.0f), Size.Y);
+		if (FillSize.X > 0.0f)
+		{
+			FSlateDrawElement::MakeBox(OutDrawElements, LayerId + 1, AllottedGeometry.ToPaintGeometry(FillSize, FSlateLayoutTransform(TopLeft)), BarBrush, ESlateDrawEffect::None, Bar.Color);
+		}
+	}
+
+	return LayerId + 1;
+}
+
+FVector2D SCombatLifeBarLayer::ComputeDesiredSize(float LayoutScaleMultiplier) const
+{
+	return FVector2D::ZeroVector;
+}
@@ -0,0 +1,65 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Widgets/SLeafWidget.h"
+
+/**
+ *  A life bar projected to the screen, ready to be drawn
+ */
+struct FCombatLifeBarScreenElement
+{
+	/** Center of the bar, in viewport pixels */
+	FVector2f Position = FVector2f::ZeroVector;
+
+	/** Size scale from distance */
+	float Scale = 1.0f;
+
+	/** Fill amount, 0-1 */
+	float Percent = 1.0f;
+
+	/** Fill color */
+	FLinearColor Color = FLinearColor::White;
+};
+
+/**
+ *  Viewport layer that draws every visible life bar in one paint pass.
+ *  The bars are projected and culled on the game thread by UCombatLifeBarSubsystem.
+ */
+class SCombatLifeBarLayer : public SLeafWidget
+{
+public:
+
+	SLATE_BEGIN_ARGS(SCombatLifeBarLayer)
+		: _BarSize(FVector2f(100.0f, 10.0f))
+		{}
+
+		/** Size of a life bar at full scale, in viewport pixels */
+		SLATE_ARGUMENT(FVector2f, BarSize)
+
+	SLATE_END_ARGS()
+
+	/** Widget construction */
+	void Construct(const FArguments& InArgs);
+
+	/** Replaces the bars to draw */
+	void SetBars(TArray<FCombatLifeBarScreenElement>&& InBars);
+
+	/** Draws the bars */
+	virtual int32 OnPaint(const FPaintArgs& Args, const FGeometry& AllottedGeometry, const FSlateRect& MyCullingRect, FSlateWindowElementList& OutDrawElements, int32 LayerId, const FWidgetStyle& InWidgetStyle, bool bParentEnabled) const override;
+
+	/** The layer covers the viewport, it doesn't need any size of its own */
+	virtual FVector2D ComputeDesiredSize(float LayoutScaleMultiplier) const override;
+
+private:
+
+	/** Bars to draw this frame */
+	TArray<FCombatLifeBarScreenElement> Bars;
+
+	/** Size of a life bar at full scale */
+	FVector2f BarSize;
+
+	/** Brush used for the bar background and fill */
+	const FSlateBrush* BarBrush = nullptr;
+};
@@ -5,18 +5,27 @@
 #include "StateTreeExecutionContext.h"
 #include "StateTreeExecutionTypes.h"
 #include "AIController.h"
-#include "Kismet/GameplayStatics.h"
+#include "PlayerTargetSubsystem.h"
 
 EStateTreeRunStatus FStateTreeGetPlayerTask::Tick(FStateTreeExecutionContext& Context, const float DeltaTime) const
 {
 	// get the instance data
 	FInstanceDataType& InstanceData = Context.GetInstanceData(*this);
 
-	// set the player pawn as the target
-	InstanceData.TargetPlayer = UGameplayStatics::GetPlayerPawn(InstanceData.Controller.Get(), 0);
+	// is the NPC valid?
+	if (!IsValid(InstanceData.NPC))
+	{
+		return EStateTreeRunStatus::Running;
+	}
+
+	// set the nearest player pawn as the target
+	if (UPlayerTargetSubsystem* PlayerTargets = InstanceData.NPC->GetWorld()->GetSubsystem<UPlayerTargetSubsystem>())
+	{
+		InstanceData.TargetPlayer = PlayerTargets->FindNearestPlayer(InstanceData.NPC->GetActorLocation());
+	}
 
-	// are the NPC and target valid?
-	if (IsValid(InstanceData.TargetPlayer) && IsValid(InstanceData.NPC))
+	// is the target valid?
+	if (IsValid(InstanceData.TargetPlayer))
 	{
 		InstanceData.bValidTarget = FVector::Distance(InstanceData.NPC->GetActorLocation(), InstanceData.TargetPlayer->GetActorLocation()) < InstanceData.RangeMax;
 	}